@@ -0,0 +1,177 @@
+// async_http_check.cpp - Drive HTTPClient's async engine against a local server
+//
+// Built and run by scripts/check_async_http.sh, which also starts the
+// stand-in server. Exercises what the interactive client does not call yet:
+// concurrent requests (postAll, chatBatch), cancelling a transfer in flight,
+// cancels racing transfers that already finished, Ctrl-C during postAll,
+// Gemini's SSE stream and closeAll() with a request still running.
+//
+// Usage: async_http_check <port> [--ollama]
+//   --ollama  the server listens on 11434, so OllamaProvider can reach it
+
+#include "llm/gemini.hpp"
+#include "llm/ollama.hpp"
+#include "utils/cancel.hpp"
+#include "utils/http.hpp"
+#include <curl/curl.h>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+static int failures = 0;
+
+static long elapsed_ms(Clock::time_point start) {
+    return (long)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+}
+
+static void check(bool ok, const std::string& what) {
+    std::cout << (ok ? "  ✅ " : "  ❌ ") << what << "\n";
+    if (!ok) failures++;
+}
+
+// The stand-in answers /slow after 1 s and anything else at once
+static void concurrent_posts(const std::string& base) {
+    std::cout << "postAll: 4 requests that take 1 s each\n";
+    auto start = Clock::now();
+    auto responses = HTTPClient::postAll(base + "/slow", {"{}", "{}", "{}", "{}"});
+    long took = elapsed_ms(start);
+    bool all_ok = responses.size() == 4;
+    for (const auto& r : responses) all_ok = all_ok && r.ok() && r.status == 200;
+    check(all_ok, "all 4 answered with HTTP 200");
+    check(took < 1800, "ran concurrently (" + std::to_string(took) + " ms)");
+}
+
+static void cancel_in_flight(const std::string& base) {
+    std::cout << "cancel: abort a 1 s request after 200 ms\n";
+    auto start = Clock::now();
+    HTTPClient::RequestId id = 0;
+    auto pending = HTTPClient::postFuture(base + "/slow", "{}", &id);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    check(HTTPClient::cancel(id), "cancel() found the transfer");
+    HTTPClient::Response r = pending.get();
+    long took = elapsed_ms(start);
+    check(r.error == "cancelled", "completed as cancelled (error: " + r.error + ")");
+    check(took < 800, "did not wait for the reply (" + std::to_string(took) + " ms)");
+    check(!HTTPClient::cancel(id), "a second cancel() reports it finished");
+}
+
+static void cancel_races_completion(const std::string& base) {
+    const int rounds = 300;
+    std::cout << "race: cancel() right after " << rounds << " requests that answer at once\n";
+    int answered = 0, cancelled = 0, other = 0, hung = 0;
+    for (int i = 0; i < rounds; i++) {
+        HTTPClient::RequestId id = 0;
+        auto pending = HTTPClient::postFuture(base + "/fast", "{}", &id);
+        // Vary the gap so some cancels land before and some after completion
+        if (i % 3 == 1) std::this_thread::sleep_for(std::chrono::microseconds(200 * (i % 7)));
+        HTTPClient::cancel(id);
+        if (pending.wait_for(std::chrono::seconds(5)) != std::future_status::ready) {
+            hung++;
+            continue;
+        }
+        HTTPClient::Response r = pending.get();
+        if (r.ok() && r.status == 200) answered++;
+        else if (r.error == "cancelled") cancelled++;
+        else other++;
+        if (HTTPClient::cancel(id)) other++;   // finished transfers must not be found
+    }
+    check(hung == 0, "every request completed (" + std::to_string(hung) + " hung)");
+    check(other == 0, "each ended answered or cancelled, exactly once (" + std::to_string(answered) +
+                      " answered, " + std::to_string(cancelled) + " cancelled, " + std::to_string(other) + " other)");
+}
+
+static void ctrl_c_during_post_all(const std::string& base) {
+    std::cout << "Ctrl-C: SIGINT 200 ms into postAll\n";
+    utils::CancelScope scope;
+    std::thread interrupter([] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        raise(SIGINT);
+    });
+    auto start = Clock::now();
+    auto responses = HTTPClient::postAll(base + "/slow", {"{}", "{}", "{}"});
+    long took = elapsed_ms(start);
+    interrupter.join();
+    bool all_cancelled = responses.size() == 3;
+    for (const auto& r : responses) all_cancelled = all_cancelled && r.error == "cancelled";
+    check(all_cancelled, "every request came back cancelled");
+    check(took < 800, "returned without waiting for the replies (" + std::to_string(took) + " ms)");
+}
+
+static void check_batch(LLMProvider& provider, const std::string& label) {
+    std::cout << label << "::chatBatch: 3 prompts the server answers after 1 s\n";
+    auto start = Clock::now();
+    auto replies = provider.chatBatch({"slow one", "slow two", "slow three"});
+    long took = elapsed_ms(start);
+    bool all_ok = replies.size() == 3;
+    for (const auto& r : replies) all_ok = all_ok && r.error.empty() && !r.content.empty();
+    check(all_ok, "3 replies with content, in order");
+    check(took < 1800, "sent concurrently (" + std::to_string(took) + " ms)");
+}
+
+// The stand-in streams 4 events with CRLF line ends, in 37-byte pieces that
+// split lines and events: text, text, two functionCalls, text with usage
+static void gemini_stream(GeminiProvider& gemini) {
+    std::cout << "GeminiProvider::chatStream: SSE split across chunks\n";
+    std::vector<std::string> pieces;
+    ChatResponse r = gemini.chatStream("hello", {}, [&](const std::string& piece) { pieces.push_back(piece); });
+    check(r.error.empty(), "no error (" + r.error + ")");
+    check(pieces.size() == 3 && r.content == "Hello!", "3 text pieces in order (" + r.content + ")");
+    bool calls = r.tool_calls.size() == 2 && r.tool_calls[0].name == "osps" && r.tool_calls[1].name == "osfind" &&
+                 r.tool_calls[0].args["limit"] == "5" && r.tool_calls[1].args["name"] == "\"a b\"";
+    check(calls, "both functionCalls of one event, with their args");
+    check(r.prompt_tokens == 12 && r.completion_tokens == 4, "usageMetadata read from the last event (" +
+          std::to_string(r.prompt_tokens) + " / " + std::to_string(r.completion_tokens) + ")");
+    check(r.first_token_ms >= 0, "first token time measured");
+
+    std::cout << "GeminiProvider::chatStream: error body instead of events\n";
+    pieces.clear();
+    r = gemini.chatStream("stream error", {}, [&](const std::string& piece) { pieces.push_back(piece); });
+    check(r.error == "API key not valid" && pieces.empty(), "the error message, no tokens (" + r.error + ")");
+}
+
+static void close_with_request_running(const std::string& base) {
+    std::cout << "closeAll: shut down with a request in flight\n";
+    auto pending = HTTPClient::postFuture(base + "/slow", "{}");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    auto start = Clock::now();
+    HTTPClient::closeAll();
+    HTTPClient::Response r = pending.get();
+    check(r.error == "cancelled", "the running request ended as cancelled (error: " + r.error + ")");
+    check(elapsed_ms(start) < 800, "closeAll() did not wait for it");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <port> [--ollama]\n";
+        return 2;
+    }
+    std::string base = std::string("http://127.0.0.1:") + argv[1];
+    bool with_ollama = argc > 2 && std::strcmp(argv[2], "--ollama") == 0;
+
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    concurrent_posts(base);
+    cancel_in_flight(base);
+    cancel_races_completion(base);
+    ctrl_c_during_post_all(base);
+
+    GeminiProvider gemini("stand-in", "key", base + "/v1beta");
+    check_batch(gemini, "GeminiProvider");
+    gemini_stream(gemini);
+    if (with_ollama) {
+        OllamaProvider ollama("stand-in");
+        check_batch(ollama, "OllamaProvider");
+    } else {
+        std::cout << "OllamaProvider::chatBatch: skipped, port 11434 is taken\n";
+    }
+
+    close_with_request_running(base);
+    curl_global_cleanup();
+
+    std::cout << (failures ? "❌ " + std::to_string(failures) + " check(s) failed\n" : "✨ all checks passed\n");
+    return failures ? 1 : 0;
+}
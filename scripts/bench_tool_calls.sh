@@ -0,0 +1,44 @@
+#!/bin/bash
+# bench_tool_calls.sh - Measure per-call overhead of mcp_server tool execution
+#
+# Usage: scripts/bench_tool_calls.sh [mcp_server binary] [calls] [tool] [arguments json]
+#
+# Pipes <calls> tools/call requests into one mcp_server process and reports
+# the average wall time per call. The default tool runs `true` through the
+# dispatcher, so the figure is almost pure spawn overhead.
+
+set -e
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+SERVER="${1:-$ROOT_DIR/build/mcp_server}"
+CALLS="${2:-200}"
+TOOL="${3:-run_shell_command}"
+ARGS="${4:-{\"command\":\"true\"\}}"
+
+if [ ! -x "$SERVER" ]; then
+    echo "❌ mcp_server not found at $SERVER (build first or pass the path)"
+    exit 1
+fi
+SERVER="$(cd "$(dirname "$SERVER")" && pwd)/$(basename "$SERVER")"
+
+# Run from a scratch dir so debug.log / the audit log do not pollute the tree
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+gen_requests() {
+    echo '{"jsonrpc":"2.0","id":1,"method":"initialize","params":{}}'
+    for i in $(seq 2 $((CALLS + 1))); do
+        echo "{\"jsonrpc\":\"2.0\",\"id\":$i,\"method\":\"tools/call\",\"params\":{\"name\":\"$TOOL\",\"arguments\":$ARGS,\"exec_dangerous\":\"NO\"}}"
+    done
+}
+
+gen_requests > "$WORK_DIR/requests.jsonl"
+
+cd "$WORK_DIR"
+start=$(date +%s%N)
+"$SERVER" < requests.jsonl > responses.jsonl 2>/dev/null
+end=$(date +%s%N)
+
+answered=$(grep -c '"result"' responses.jsonl || true)
+total_us=$(( (end - start) / 1000 ))
+echo "⏱  $TOOL: $answered/$((CALLS + 1)) responses, total ${total_us} us, $(( total_us / CALLS )) us/call"
@@ -0,0 +1,123 @@
+#!/bin/bash
+# check_async_http.sh - Exercise the async HTTP engine against a local stand-in
+#
+# Usage: scripts/check_async_http.sh
+#
+# Starts a small Python server that answers like Ollama (/api/chat) and
+# Gemini (:generateContent, :streamGenerateContent), builds
+# scripts/async_http_check.cpp against the client's HTTP and provider
+# sources, and runs it: concurrent postAll and chatBatch, cancel in flight,
+# cancels racing finished transfers, Ctrl-C during postAll, Gemini's
+# chatStream and closeAll() with a request running. The server takes
+# Ollama's port 11434 when it is free; otherwise the Ollama check is skipped.
+
+set -e
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+CXX="${CXX:-c++}"
+
+# Run from a scratch dir so debug.log does not pollute the tree
+WORK_DIR="$(mktemp -d)"
+SERVER_PID=""
+cleanup() {
+    if [ -n "$SERVER_PID" ]; then kill "$SERVER_PID" 2>/dev/null || true; fi
+    rm -rf "$WORK_DIR"
+}
+trap cleanup EXIT
+
+cat > "$WORK_DIR/standin.py" <<'EOF'
+import json, sys, time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def log_message(self, *args):
+        pass
+
+    def reply(self, obj):
+        body = json.dumps(obj).encode()
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def stream(self, request):
+        # SSE with CRLF line ends, sent in pieces that cut through lines
+        if "stream error" in request:
+            body = json.dumps({"error": {"code": 400, "message": "API key not valid", "status": "INVALID_ARGUMENT"}}).encode()
+            self.send_response(400)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+            return
+        events = [
+            {"candidates": [{"content": {"role": "model", "parts": [{"text": "Hel"}]}}]},
+            {"candidates": [{"content": {"role": "model", "parts": [{"text": "lo"}]}}]},
+            {"candidates": [{"content": {"role": "model", "parts": [
+                {"functionCall": {"name": "osps", "args": {"limit": 5}}},
+                {"functionCall": {"name": "osfind", "args": {"path": "/tmp", "name": "a b"}}}]}}]},
+            {"candidates": [{"content": {"role": "model", "parts": [{"text": "!"}]}, "finishReason": "STOP"}],
+             "usageMetadata": {"promptTokenCount": 12, "candidatesTokenCount": 4, "totalTokenCount": 16}},
+        ]
+        stream = "".join("data: " + json.dumps(e) + "\r\n\r\n" for e in events).encode()
+        self.send_response(200)
+        self.send_header("Content-Type", "text/event-stream")
+        self.send_header("Transfer-Encoding", "chunked")
+        self.end_headers()
+        for i in range(0, len(stream), 37):
+            part = stream[i:i + 37]
+            self.wfile.write(b"%x\r\n%s\r\n" % (len(part), part))
+            self.wfile.flush()
+            time.sleep(0.005)
+        self.wfile.write(b"0\r\n\r\n")
+
+    def do_POST(self):
+        request = self.rfile.read(int(self.headers.get("Content-Length", 0))).decode()
+        if ":streamGenerateContent" in self.path:
+            self.stream(request)
+            return
+        if self.path.startswith("/slow") or "slow" in request:
+            time.sleep(1)
+        if self.path.startswith("/api/chat"):
+            self.reply({"model": "stand-in", "message": {"role": "assistant", "content": "ollama reply"}, "done": True})
+        elif ":generateContent" in self.path:
+            self.reply({"candidates": [{"content": {"role": "model", "parts": [{"text": "gemini reply"}]}}]})
+        else:
+            self.reply({"ok": True})
+
+ThreadingHTTPServer(("127.0.0.1", int(sys.argv[1])), Handler).serve_forever()
+EOF
+
+port_free() {
+    ! (exec 3<>"/dev/tcp/127.0.0.1/$1") 2>/dev/null
+}
+
+PORT=11434
+OLLAMA_FLAG="--ollama"
+if ! port_free "$PORT"; then
+    PORT=18434
+    OLLAMA_FLAG=""
+fi
+
+echo "🔨 Building the driver..."
+"$CXX" -std=c++17 -O1 -I"$ROOT_DIR/src/include" -o "$WORK_DIR/async_http_check" \
+    "$ROOT_DIR/scripts/async_http_check.cpp" \
+    "$ROOT_DIR/src/src/utils/http.cpp" "$ROOT_DIR/src/src/utils/json.cpp" \
+    "$ROOT_DIR/src/src/llm/ollama.cpp" "$ROOT_DIR/src/src/llm/gemini.cpp" \
+    "$ROOT_DIR/src/src/llm/conversation.cpp" \
+    -lcurl -lpthread
+
+# Clients that cancel leave broken pipes behind; the tracebacks are noise
+python3 "$WORK_DIR/standin.py" "$PORT" 2>/dev/null &
+SERVER_PID=$!
+for _ in $(seq 50); do
+    port_free "$PORT" || break
+    sleep 0.1
+done
+
+echo "🌐 Stand-in server on port $PORT"
+cd "$WORK_DIR"
+./async_http_check "$PORT" $OLLAMA_FLAG
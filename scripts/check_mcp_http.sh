@@ -0,0 +1,167 @@
+#!/bin/bash
+# check_mcp_http.sh - Exercise the MCP streamable HTTP transport against a stand-in
+#
+# Usage: scripts/check_mcp_http.sh [port]
+#
+# Starts a small Python MCP server on one endpoint (default port 18435),
+# builds scripts/mcp_http_check.cpp against the client's MCP sources, and
+# runs it: JSON and SSE replies, Mcp-Session-Id round-tripping, progress
+# notifications, Ctrl-C sending notifications/cancelled, and the DELETE
+# that ends the session.
+
+set -e
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+CXX="${CXX:-c++}"
+PORT="${1:-18435}"
+
+# Run from a scratch dir so debug.log does not pollute the tree
+WORK_DIR="$(mktemp -d)"
+SERVER_PID=""
+cleanup() {
+    if [ -n "$SERVER_PID" ]; then kill "$SERVER_PID" 2>/dev/null || true; fi
+    rm -rf "$WORK_DIR"
+}
+trap cleanup EXIT
+
+cat > "$WORK_DIR/standin.py" <<'EOF'
+import itertools, json, sys, threading, time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+lock = threading.Lock()
+next_session = itertools.count(1)
+sessions = {}      # id -> {"unmatched": n, "cancelled": [...]}
+deleted = []
+
+TOOLS = [{"name": n, "description": n, "inputSchema": {"type": "object"}} for n in ("echo", "stream", "slow", "seen")]
+
+def text_result(req_id, text):
+    return {"jsonrpc": "2.0", "id": req_id, "result": {"content": [{"type": "text", "text": text}]}}
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def log_message(self, *args):
+        pass
+
+    def send_json(self, obj, session=None):
+        body = json.dumps(obj).encode()
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json")
+        if session:
+            self.send_header("Mcp-Session-Id", session)
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def send_events(self, messages):
+        # CRLF line ends, and each event split across two chunks
+        self.send_response(200)
+        self.send_header("Content-Type", "text/event-stream")
+        self.send_header("Transfer-Encoding", "chunked")
+        self.end_headers()
+        for message in messages:
+            event = ("event: message\r\ndata: " + json.dumps(message) + "\r\n\r\n").encode()
+            for part in (event[:len(event) // 2], event[len(event) // 2:]):
+                self.wfile.write(b"%x\r\n%s\r\n" % (len(part), part))
+                self.wfile.flush()
+            time.sleep(0.02)
+        self.wfile.write(b"0\r\n\r\n")
+
+    def do_DELETE(self):
+        with lock:
+            deleted.append(self.headers.get("Mcp-Session-Id", ""))
+        self.send_response(200)
+        self.send_header("Content-Length", "0")
+        self.end_headers()
+
+    def do_POST(self):
+        message = json.loads(self.rfile.read(int(self.headers.get("Content-Length", 0))))
+        method = message.get("method", "")
+        if method == "initialize":
+            session = "session-%d" % next(next_session)
+            with lock:
+                sessions[session] = {"unmatched": 0, "cancelled": []}
+            self.send_json({"jsonrpc": "2.0", "id": message["id"], "result": {
+                "protocolVersion": "2025-03-26", "capabilities": {"tools": {}},
+                "serverInfo": {"name": "stand-in", "version": "1"}}}, session)
+            return
+
+        session = self.headers.get("Mcp-Session-Id", "")
+        with lock:
+            if session not in sessions:
+                for state in sessions.values():
+                    state["unmatched"] += 1
+                self.send_response(404)
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+                return
+            state = sessions[session]
+            if method == "notifications/cancelled":
+                state["cancelled"].append(message.get("params", {}))
+
+        if "id" not in message:
+            self.send_response(202)
+            self.send_header("Content-Length", "0")
+            self.end_headers()
+            return
+
+        req_id = message["id"]
+        if method == "tools/list":
+            note = {"jsonrpc": "2.0", "method": "notifications/message", "params": {"level": "info", "data": "listing"}}
+            self.send_events([note, {"jsonrpc": "2.0", "id": req_id, "result": {"tools": TOOLS}}])
+            return
+
+        params = message.get("params", {})
+        name = params.get("name")
+        args = params.get("arguments", {})
+        if name == "echo":
+            self.send_json(text_result(req_id, args.get("text", "")))
+        elif name == "stream":
+            token = params.get("_meta", {}).get("progressToken")
+            events = [{"jsonrpc": "2.0", "method": "notifications/progress",
+                       "params": {"progressToken": token, "progress": i + 1, "message": line + "\n"}}
+                      for i, line in enumerate(("one", "two", "three"))]
+            self.send_events(events + [text_result(req_id, "three")])
+        elif name == "slow":
+            time.sleep(3)
+            self.send_json(text_result(req_id, "too late"))
+        elif name == "seen":
+            with lock:
+                report = {"session": session, "unmatched": state["unmatched"],
+                          "cancelled": state["cancelled"], "deleted": deleted}
+            self.send_json(text_result(req_id, json.dumps(report)))
+        else:
+            self.send_json({"jsonrpc": "2.0", "id": req_id, "error": {"code": -32602, "message": "unknown tool"}})
+
+ThreadingHTTPServer(("127.0.0.1", int(sys.argv[1])), Handler).serve_forever()
+EOF
+
+port_free() {
+    ! (exec 3<>"/dev/tcp/127.0.0.1/$1") 2>/dev/null
+}
+
+if ! port_free "$PORT"; then
+    echo "❌ port $PORT is taken (pass another one)"
+    exit 1
+fi
+
+echo "🔨 Building the driver..."
+"$CXX" -std=c++17 -O1 -I"$ROOT_DIR/src/include" -o "$WORK_DIR/mcp_http_check" \
+    "$ROOT_DIR/scripts/mcp_http_check.cpp" \
+    "$ROOT_DIR/src/src/mcp/server_proxy.cpp" "$ROOT_DIR/src/src/mcp/transport.cpp" \
+    "$ROOT_DIR/src/src/mcp/http_transport.cpp" \
+    "$ROOT_DIR/src/src/utils/json.cpp" "$ROOT_DIR/src/src/utils/jsonrpc.cpp" \
+    -lcurl -lpthread
+
+# The cancelled call leaves a broken pipe behind; the traceback is noise
+python3 "$WORK_DIR/standin.py" "$PORT" 2>/dev/null &
+SERVER_PID=$!
+for _ in $(seq 50); do
+    port_free "$PORT" || break
+    sleep 0.1
+done
+
+echo "🌐 Stand-in MCP server on port $PORT"
+cd "$WORK_DIR"
+./mcp_http_check "$PORT"
@@ -0,0 +1,105 @@
+// mcp_http_check.cpp - Drive the MCP streamable HTTP transport against a stand-in
+//
+// Built and run by scripts/check_mcp_http.sh, which also starts the stand-in
+// MCP server. Checks plain JSON and SSE replies (CRLF, events split across
+// chunks, notifications ahead of the answer), Mcp-Session-Id round-tripping,
+// progress notifications, Ctrl-C sending notifications/cancelled, and the
+// DELETE that ends the session on disconnect.
+//
+// Usage: mcp_http_check <port>
+
+#include "mcp/server_proxy.hpp"
+#include "utils/cancel.hpp"
+#include "utils/json.hpp"
+#include <curl/curl.h>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+static int failures = 0;
+
+static void check(bool ok, const std::string& what) {
+    std::cout << (ok ? "  ✅ " : "  ❌ ") << what << "\n";
+    if (!ok) failures++;
+}
+
+static bool contains(const std::string& text, const std::string& part) {
+    return text.find(part) != std::string::npos;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <port>\n";
+        return 2;
+    }
+    std::string url = std::string("http://127.0.0.1:") + argv[1] + "/mcp";
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    std::string first_session;
+    {
+        MCPServer server("stand-in");
+        std::cout << "initialize: JSON reply that assigns a session\n";
+        check(server.connectRemote(url), "connected and initialized");
+
+        std::cout << "tools/list: SSE reply, CRLF, a notification first, split across chunks\n";
+        std::string tools = server.listTools();
+        check(contains(tools, "\"echo\"") && contains(tools, "\"slow\""), "tool list parsed from the event stream");
+
+        std::cout << "tools/call: plain JSON reply\n";
+        check(server.callTool("echo", "{\"text\":\"hello\"}", 0) == "hello", "echo returned its text");
+
+        std::cout << "tools/call: SSE with progress notifications ahead of the result\n";
+        std::string streamed;
+        int pieces = 0;
+        server.setProgressHandler([&](const std::string& text) {
+            streamed += text;
+            pieces++;
+        });
+        std::string result = server.callTool("stream", "{}", 0);
+        server.setProgressHandler(nullptr);
+        check(pieces == 3, "3 progress pieces arrived (" + std::to_string(pieces) + ")");
+        check(streamed == "one\ntwo\nthree\n", "the pieces carry the output in order");
+
+        std::cout << "cancel: Ctrl-C 300 ms into a 3 s call\n";
+        {
+            utils::CancelScope scope;
+            std::thread interrupter([] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(300));
+                raise(SIGINT);
+            });
+            auto start = Clock::now();
+            result = server.callTool("slow", "{}", 0);
+            long took = (long)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+            interrupter.join();
+            check(contains(result, "cancelled by user"), "the call reports the cancel (" + result + ")");
+            check(took < 1500, "it did not wait for the reply (" + std::to_string(took) + " ms)");
+        }
+
+        std::cout << "session: what the server saw\n";
+        std::string seen = server.callTool("seen", "{}", 0);
+        first_session = json::parse::get_string(seen, "session");
+        check(!first_session.empty(), "the server assigned session " + first_session);
+        check(json::parse::get_raw_value(seen, "\"unmatched\":") == "0",
+              "every later request carried that Mcp-Session-Id");
+        check(contains(json::parse::get_array(seen, "cancelled"), "\"reason\": \"cancelled by user\""),
+              "notifications/cancelled reached the server");
+        // Leaving the scope disconnects: DELETE with the session id
+    }
+
+    {
+        std::cout << "close: DELETE ends the session\n";
+        MCPServer server("stand-in");
+        check(server.connectRemote(url), "reconnected");
+        std::string seen = server.callTool("seen", "{}", 0);
+        check(contains(json::parse::get_array(seen, "deleted"), "\"" + first_session + "\""),
+              "the first session was deleted on disconnect");
+        check(json::parse::get_string(seen, "session") != first_session, "the new connection got a new session");
+    }
+
+    curl_global_cleanup();
+    std::cout << (failures ? "❌ " + std::to_string(failures) + " check(s) failed\n" : "✨ all checks passed\n");
+    return failures ? 1 : 0;
+}
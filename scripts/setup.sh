@@ -81,13 +81,9 @@ sudo chmod +x /usr/local/bin/mcp_server
 echo "📁 Installing tools to /usr/local/share/ollmcpc/tools..."
 sudo mkdir -p /usr/local/share/ollmcpc/tools
 sudo cp tools/*.sh /usr/local/share/ollmcpc/tools/
-# Compile and install dispatcher if source exists
-if [ -f "tools/dispatcher.c" ]; then
-    gcc tools/dispatcher.c -o tools/dispatcher 2>/dev/null || true
-fi
-if [ -f "tools/dispatcher" ]; then
-    sudo cp tools/dispatcher /usr/local/share/ollmcpc/tools/
-fi
+sudo cp tools/manifest.json /usr/local/share/ollmcpc/tools/
+# The build above puts the dispatcher next to mcp_server
+sudo cp build/dispatcher /usr/local/share/ollmcpc/tools/
 sudo chmod +x /usr/local/share/ollmcpc/tools/*
 
 echo ""
@@ -7,13 +7,34 @@
 struct Config {
     std::string default_provider = "ollama";
     std::string ollama_model = "functiongemma";
+    bool ollama_preload = true;                  // load the model while the MCP servers start
+    std::string ollama_keep_alive = "30m";       // idle time before Ollama unloads it, "" = Ollama's default
+    int ollama_num_ctx = 0;                      // context window in tokens, 0 = model default
+    int ollama_num_thread = 0;                   // generation threads, 0 = Ollama's choice
+    int ollama_num_batch = 0;                    // prompt batch size, 0 = Ollama's default
     std::string gemini_api_key = "";
     std::string gemini_model = "gemini-1.5-flash";
+    std::string gemini_url = "https://generativelanguage.googleapis.com/v1beta";   // API base
     bool human_in_loop = true;
+    int http_connect_timeout_ms = 10000;         // LLM provider HTTP: TCP/TLS connect deadline
+    int http_timeout_ms = 120000;                // whole request; stall limit for streamed replies
+
+    // Built-in os-assistant server (mcp_server) tuning
+    int server_workers = 4;                      // concurrent tools/call workers
+    std::vector<std::string> tool_limits;        // "tool=N" per-tool concurrency caps
+    int server_cache_mb = 8;                     // read-only tool result cache, 0 = off
+    int server_zygote_workers = 4;               // warm pre-forked tool workers, 0 = off
+    int server_worker_max_jobs = 100;            // jobs per warm worker before it is recycled
+    bool server_cgroups = false;                 // run each tool in a cgroup v2 child
+    std::string server_cgroup_root;              // delegated cgroup to use, "" = our own
+    bool server_shell_session = false;           // one persistent shell for run_shell_command
     
     struct MCPServerConfig {
         std::string name;
         std::vector<std::string> command;
+        std::string transport = "stdio";   // "stdio" or "http"
+        std::string url;                   // MCP endpoint when transport == "http"
+        int timeout_ms = 30000;            // deadline for every request to this server
         bool enabled = true;
     };
     std::vector<MCPServerConfig> servers;
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+
+// =============================================================================
+// Conversation (chat history and replies)
+// =============================================================================
+//
+// ChatResponse is what every provider's chat() returns: the reply parsed
+// once, from whatever the backend's wire format is, into plain fields.
+//
+// The messages of a session, each stored once as plain text and, per
+// provider wire format, appended to a growing serialized buffer the first
+// time a request needs it. A request then copies the buffer instead of
+// re-serializing every past message, so a turn costs O(new bytes) of JSON
+// work rather than O(history).
+//
+//   OLLAMA  {"content":"..","role":".."},...         (the "messages" items)
+//   GEMINI  {"parts":[{"text":".."}],"role":"user|model"},...
+//           system messages are left out and exposed as systemPrompt()
+//
+// The buffers are a cache, filled lazily from a const Conversation; like
+// the providers, a Conversation is used by one thread at a time.
+//
+// =============================================================================
+
+struct ChatMessage {
+    std::string role;       // "system", "user" or "assistant"
+    std::string content;
+};
+
+struct ToolCall {
+    std::string name;
+    std::string arguments;                       // JSON object, on one line
+    std::map<std::string, std::string> args;     // its members, values as raw JSON
+};
+
+struct ChatResponse {
+    std::string content;
+    std::vector<ToolCall> tool_calls;
+    std::string error;              // the backend's error or a transport failure; "" if it answered
+
+    // Token counts as the backend reports them, -1 if it does not
+    long prompt_tokens = -1;
+    long completion_tokens = -1;
+
+    // Measured around the request; first_token_ms only when streamed
+    long first_token_ms = -1;
+    long total_ms = -1;
+    // Ollama's own breakdown, -1 elsewhere
+    double load_ms = -1;
+    double prompt_eval_ms = -1;
+    double eval_ms = -1;
+
+    /// Append a call; arguments is the raw JSON value (an object, or a
+    /// string holding one) and is compacted and split into args
+    void addToolCall(const std::string& name, const std::string& arguments);
+};
+
+class Conversation {
+public:
+    enum Format { OLLAMA = 0, GEMINI, FORMAT_COUNT };
+
+    void add(const std::string& role, const std::string& content);
+    void clear();
+
+    const std::vector<ChatMessage>& messages() const { return items; }
+    bool empty() const { return items.empty(); }
+    size_t size() const { return items.size(); }
+
+    /// The messages as comma-separated JSON items in format, without the
+    /// enclosing brackets; only messages added since the last call are
+    /// serialized
+    const std::string& serialized(Format format) const;
+
+    /// Text of the latest system message, "" if there is none
+    const std::string& systemPrompt() const { return system_prompt; }
+
+private:
+    struct Buffer {
+        std::string json;
+        size_t count = 0;                 // messages already in json
+    };
+
+    std::vector<ChatMessage> items;
+    std::string system_prompt;
+    mutable Buffer buffers[FORMAT_COUNT];
+
+    static bool append(Format format, const ChatMessage& message, std::string& out);
+};
@@ -8,18 +8,39 @@ class GeminiProvider : public LLMProvider {
 private:
     std::string api_key;
     std::string model_name;
+    std::string api_url;                  // ".../v1beta"; a local stand-in for testing
     std::vector<std::string> tools_json;  // JSON representation for API
 
+    // Serialized once and reused until the tools (or the system prompt) change
+    std::string tools_block;              // ,"tools":[{"function_declarations":[...]}]}
+    bool tools_block_valid = false;
+    std::string system_text;              // the system prompt system_block was made from
+    std::string system_block;             // ,"system_instruction":{...}
+
+    std::string build_request(const std::string& user_message,
+                              const Conversation& history);
+
 public:
-    GeminiProvider(const std::string& model, const std::string& key);
+    static constexpr const char* DEFAULT_URL = "https://generativelanguage.googleapis.com/v1beta";
+
+    GeminiProvider(const std::string& model, const std::string& key, const std::string& url = DEFAULT_URL);
     
-    std::string chat(const std::string& user_message, 
-                     const std::vector<std::map<std::string, std::string>>& history = {}) override;
+    ChatResponse chat(const std::string& user_message, 
+                      const Conversation& history = {}) override;
+
+    /// :streamGenerateContent?alt=sse; text parts go to on_token per event
+    ChatResponse chatStream(const std::string& user_message,
+                            const Conversation& history,
+                            const TokenHandler& on_token) override;
+
+    /// All requests in flight at once on the async HTTP engine
+    std::vector<ChatResponse> chatBatch(const std::vector<std::string>& user_messages,
+                                        const Conversation& history = {}) override;
     
     void addTool(const std::string& name, const std::string& description, 
                  const std::string& parameters) override;
     
     std::string name() const override { return "gemini"; }
-    void clearTools() override { tools.clear(); tools_json.clear(); }
+    void clearTools() override { tools.clear(); tools_json.clear(); tools_block_valid = false; }
     // getTools() inherited from base class
 };
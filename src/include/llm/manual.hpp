@@ -4,8 +4,8 @@
 
 class ManualProvider : public LLMProvider {
 public:
-    std::string chat(const std::string& user_message, 
-                     const std::vector<std::map<std::string, std::string>>& history = {}) override;
+    ChatResponse chat(const std::string& user_message, 
+                      const Conversation& history = {}) override;
     
     void addTool(const std::string& name, const std::string& description, 
                  const std::string& parameters) override;
@@ -4,22 +4,55 @@
 #include <string>
 #include <vector>
 
+/// Model settings sent with every request; empty or 0 keeps Ollama's default
+struct OllamaOptions {
+    std::string keep_alive;   // how long the model stays loaded when idle: "30m", "-1" forever, "0" unload
+    int num_ctx = 0;          // context window, in tokens
+    int num_thread = 0;       // CPU threads for generation
+    int num_batch = 0;        // prompt tokens evaluated per batch
+};
+
 class OllamaProvider : public LLMProvider {
 private:
     std::string model_name;
     std::string ollama_url;
+    OllamaOptions options;
     std::vector<std::string> tools_json;  // JSON representation for API
 
+    // Serialized once: {"keep_alive":..,"messages":[ before the messages,
+    // and per tool set everything after them:
+    // ],"model":..,"options":{..},"stream":false|true,"tools":[...]}
+    std::string request_head;
+    std::string options_json;             // "" when no option is set
+    std::string request_tail[2];          // [stream]
+    bool request_tail_valid = false;
+
+    std::string build_request(const std::string& user_message,
+                              const Conversation& history, bool stream);
+
 public:
-    OllamaProvider(const std::string& model);
+    OllamaProvider(const std::string& model, const OllamaOptions& options = {});
+    
+    ChatResponse chat(const std::string& user_message, 
+                      const Conversation& history = {}) override;
+
+    /// "stream": true; content goes to on_token chunk by chunk (NDJSON)
+    ChatResponse chatStream(const std::string& user_message,
+                            const Conversation& history,
+                            const TokenHandler& on_token) override;
+
+    /// All requests in flight at once on the async HTTP engine
+    std::vector<ChatResponse> chatBatch(const std::vector<std::string>& user_messages,
+                                        const Conversation& history = {}) override;
     
-    std::string chat(const std::string& user_message, 
-                     const std::vector<std::map<std::string, std::string>>& history = {}) override;
+    /// POST an empty message list, which makes Ollama load the model with
+    /// these options and keep_alive
+    std::future<ChatResponse> warmUp() override;
     
     void addTool(const std::string& name, const std::string& description, 
                  const std::string& parameters) override;
     
     std::string name() const override { return "ollama"; }
-    void clearTools() override { tools.clear(); tools_json.clear(); }
+    void clearTools() override { tools.clear(); tools_json.clear(); request_tail_valid = false; }
     // getTools() inherited from base class
 };
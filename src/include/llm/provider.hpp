@@ -1,8 +1,12 @@
 #pragma once
 
+#include "llm/conversation.hpp"
+
 #include <string>
 #include <vector>
 #include <map>
+#include <functional>
+#include <future>
 
 struct Tool {
     std::string name;
@@ -23,10 +27,39 @@ protected:
     }
 
 public:
+    /// Receives the reply's text as it is generated
+    using TokenHandler = std::function<void(const std::string& text)>;
+
     virtual ~LLMProvider() = default;
     
-    virtual std::string chat(const std::string& user_message, 
-                             const std::vector<std::map<std::string, std::string>>& history = {}) = 0;
+    /// The reply, parsed; on failure content and tool_calls are empty and
+    /// error says why
+    virtual ChatResponse chat(const std::string& user_message, 
+                              const Conversation& history = {}) = 0;
+
+    /// chat() that hands the content to on_token as it arrives and returns
+    /// the same response, with the full content and all tool_calls. Providers
+    /// without a streaming API answer through chat() and never call on_token.
+    virtual ChatResponse chatStream(const std::string& user_message,
+                                    const Conversation& history,
+                                    const TokenHandler& on_token) {
+        (void)on_token;
+        return chat(user_message, history);
+    }
+
+    /// One chat() per message, all on the same history, answered in order.
+    /// HTTP providers send them concurrently; Ctrl-C cancels what is left.
+    virtual std::vector<ChatResponse> chatBatch(const std::vector<std::string>& user_messages,
+                                                const Conversation& history = {}) {
+        std::vector<ChatResponse> replies;
+        for (const auto& message : user_messages) replies.push_back(chat(message, history));
+        return replies;
+    }
+    
+    /// Get the backend ready for the first chat() (load the model) without
+    /// blocking; the outcome, with load_ms, arrives through the future.
+    /// Providers with nothing to prepare return an invalid future.
+    virtual std::future<ChatResponse> warmUp() { return {}; }
     
     virtual void addTool(const std::string& name, const std::string& description, 
                          const std::string& parameters) = 0;
@@ -9,10 +9,15 @@
 
 inline std::unique_ptr<LLMProvider> createProvider(const Config& config) {
     if (config.default_provider == "gemini") {
-        return std::make_unique<GeminiProvider>(config.gemini_model, config.gemini_api_key);
+        return std::make_unique<GeminiProvider>(config.gemini_model, config.gemini_api_key, config.gemini_url);
     } else if (config.default_provider == "manual" || config.default_provider == "none") {
         return std::make_unique<ManualProvider>();
     } else {
-        return std::make_unique<OllamaProvider>(config.ollama_model);
+        OllamaOptions options;
+        options.keep_alive = config.ollama_keep_alive;
+        options.num_ctx = config.ollama_num_ctx;
+        options.num_thread = config.ollama_num_thread;
+        options.num_batch = config.ollama_num_batch;
+        return std::make_unique<OllamaProvider>(config.ollama_model, options);
     }
 }
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// =============================================================================
+// Argument Binder (mcp_server side)
+// =============================================================================
+//
+// Turns the JSON arguments of a tools/call into the script's argv. Each
+// tool's manifest "args" mapping and its inputSchema are compiled once at
+// manifest load into slots that know the argument's type (string, integer,
+// number, boolean), its aliases and whether it is required.
+//
+// bind() walks the arguments object once. Values are checked against their
+// type and normalized, so 42, "42" and 42.0 all bind as "42", and a wrong
+// value fails with a message naming the argument and what was expected.
+// Arguments the tool does not declare are ignored.
+//
+// =============================================================================
+
+/// One entry of a tool's manifest "args" mapping
+struct ToolArg {
+    std::string key;
+    std::vector<std::string> aliases;
+    std::string flag;        // emitted before the value, or alone for switches
+    bool is_switch = false;  // boolean: emit flag only when true
+    bool required = false;
+};
+
+class ArgBinder {
+public:
+    ArgBinder() = default;
+
+    /// Compile args against inputSchema's properties and required list
+    ArgBinder(const std::string& tool_name, const std::vector<ToolArg>& args,
+              const std::string& input_schema);
+
+    /// Append argv for args_json in manifest order. On invalid arguments,
+    /// returns false with error set ("Error: <tool> ...").
+    bool bind(const std::string& args_json, std::vector<std::string>& argv, std::string& error) const;
+
+private:
+    enum class Type { Any, String, Integer, Number, Boolean };
+
+    struct Slot {
+        ToolArg spec;
+        Type type = Type::Any;
+        bool required = false;
+    };
+
+    std::string tool_name;
+    std::vector<Slot> slots;
+    // Argument name -> (slot, rank); rank 0 is the key, 1.. its aliases in order
+    std::unordered_map<std::string, std::pair<size_t, size_t>> names;
+
+    static Type type_of(const std::string& schema_type);
+    static const char* type_name(Type type);
+    bool convert(const Slot& slot, const std::string& raw, std::string& value, std::string& error) const;
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "audit_log.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+// =============================================================================
+// Audit Store (mcp_server side)
+// =============================================================================
+//
+// Read side of the binary audit log (tools/audit_log.h), behind the
+// osaudit_query tool. The log is already an append-only, time-ordered series
+// of segments: the sealed system_audit-*.bin files plus the live
+// system_audit.bin. Queries filter on user, command, status and a time
+// range, newest first.
+//
+// A sealed segment never changes, so the first query that reaches it writes
+// an index next to it (system_audit-*.idx, built in memory if the directory
+// is read-only):
+//
+//   IndexHeader                       records, time span, size of the .bin
+//   IndexKey[]  per user/command/status, sorted by key hash
+//   uint32_t[]  postings: record numbers per key, ascending
+//
+// Later queries mmap the .bin and the .idx, skip segments outside the time
+// range by the header alone, binary-search each filter's key and walk the
+// shortest posting list. Every candidate is checked against the record
+// itself, so hash collisions only cost a comparison. The live file is
+// indexed in memory, incrementally, up to its current size.
+//
+// Commands match on their base name without ".sh" ("osshm_list" finds
+// /path/tools/osshm_list.sh); a command with a '/' must match exactly.
+//
+// =============================================================================
+
+/// Filters for AuditStore::query; empty strings match anything
+struct AuditQuery {
+    std::string user;
+    std::string command;
+    int status = -1;                  // AuditStatus, -1 = any
+    int64_t since_us = 0;
+    int64_t until_us = INT64_MAX;
+    size_t limit = 50;
+
+    /// From the tool's argv: --user U --command C --status S --since T
+    /// --until T --limit N. Times are "7d", "12h", "30m", epoch seconds or
+    /// "YYYY-MM-DD[ HH:MM[:SS]]" in local time.
+    bool parse(const std::vector<std::string>& args, std::string& error);
+};
+
+class AuditStore {
+public:
+    explicit AuditStore(const std::string& directory = ".");
+    ~AuditStore();
+    AuditStore(const AuditStore&) = delete;
+    AuditStore& operator=(const AuditStore&) = delete;
+
+    /// Matching records, newest first, at most query.limit. more is set when
+    /// the limit cut the result short.
+    std::vector<AuditRecord> query(const AuditQuery& query, bool* more = nullptr,
+                                   size_t* segments_read = nullptr, size_t* candidates = nullptr);
+
+    /// The tool's text: a summary line, then one export-format line per record
+    std::string run(const AuditQuery& query);
+
+private:
+    enum Dimension { DIM_USER = 0, DIM_COMMAND, DIM_STATUS, DIM_COUNT };
+
+    struct Postings {
+        const uint32_t* ids = nullptr;
+        size_t count = 0;
+    };
+
+    struct Segment;       // a sealed .bin with its index
+    struct LiveIndex {    // the growing system_audit.bin
+        dev_t dev = 0;
+        ino_t ino = 0;
+        size_t records = 0;
+        int64_t min_us = 0, max_us = 0;
+        std::unordered_map<uint64_t, std::vector<uint32_t>> keys[DIM_COUNT];
+    };
+
+    std::string directory;
+    std::mutex mutex;     // one query at a time; guards everything below
+    std::map<std::string, std::unique_ptr<Segment>> segments;   // by file name
+    LiveIndex live;
+
+    void refresh_segments();
+    std::unique_ptr<Segment> open_segment(const std::string& name);
+    void update_live(const AuditRecord* recs, size_t count, const struct stat& st);
+
+    static uint64_t key_hash(Dimension dim, const AuditRecord& rec);
+    static uint64_t query_hash(Dimension dim, const AuditQuery& query);
+    static bool matches(const AuditRecord& rec, const AuditQuery& query);
+    static void collect(const AuditRecord* recs, size_t count, const std::vector<Postings>& lists,
+                        const AuditQuery& query, std::vector<AuditRecord>& out, size_t want,
+                        size_t& candidates);
+};
@@ -12,11 +12,12 @@ public:
     MCPClient(std::unique_ptr<LLMProvider> provider);
     ~MCPClient();
 
-    void addServer(const std::string& name, const std::vector<std::string>& command);
+    void addServer(const std::string& name, const std::vector<std::string>& command, int timeout_ms = 0);
+    void addRemoteServer(const std::string& name, const std::string& url, int timeout_ms = 0);
     
     // Core chat method
-    std::string chat(const std::string& user_message, 
-                     const std::vector<std::map<std::string, std::string>>& history = {});
+    ChatResponse chat(const std::string& user_message, 
+                      const Conversation& history = {});
     
     void setProvider(std::unique_ptr<LLMProvider> new_provider);
     
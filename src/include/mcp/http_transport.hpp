@@ -0,0 +1,59 @@
+#pragma once
+
+#include "mcp/transport.hpp"
+#include <string>
+#include <deque>
+
+// =============================================================================
+// MCP Streamable HTTP Transport
+// =============================================================================
+//
+// Every client message is POSTed to a single MCP endpoint. The server answers
+// either with a plain application/json body or with a text/event-stream whose
+// "data:" events carry JSON-RPC messages (notifications first, then the
+// response). Both forms end up as lines in the same inbox that
+// MCPServer::readResponse() drains.
+//
+// One CURL easy handle lives for the whole session, so the TCP (and TLS)
+// connection is kept alive and reused between calls; HTTP/2 is negotiated on
+// https endpoints so concurrent streams share it as well.
+//
+// Spec: https://modelcontextprotocol.io/specification/2025-03-26/basic/transports
+//
+// =============================================================================
+
+class HttpTransport : public MCPTransport {
+private:
+    std::string url;
+    std::string session_id;      // Mcp-Session-Id assigned by the server
+    void* curl;                  // CURL*, kept opaque so callers skip curl.h
+    std::deque<std::string> inbox;
+
+    // Per-response parse state (reset before every POST)
+    std::string content_type;
+    std::string body;            // application/json accumulator
+    std::string sse_line;        // partial SSE line
+    std::string sse_data;        // data of the event being assembled
+    bool abortable;              // Ctrl-C may abort the POST in flight
+    long connections_opened;
+
+    static size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp);
+    static size_t header_callback(char* buffer, size_t size, size_t nitems, void* userp);
+    static int progress_callback(void* userp, long long dltotal, long long dlnow,
+                                 long long ultotal, long long ulnow);
+    void feed(const char* data, size_t len);
+    void feed_sse_line(const std::string& line);
+
+public:
+    HttpTransport(const std::string& url);
+    ~HttpTransport() override;
+
+    bool open() override;
+    bool send(const std::string& message, Deadline deadline, bool abortable) override;
+    RecvStatus receive(std::string& line, Deadline deadline) override;
+    void close() override;
+    std::string describe() const override;
+
+    /// Number of new TCP connections libcurl had to open (1 == full reuse)
+    long connectionsOpened() const { return connections_opened; }
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <sys/types.h>
+
+// =============================================================================
+// Native Process Tools (mcp_server side)
+// =============================================================================
+//
+// In-process versions of the most-called /proc tools (osps, osuptime_plus,
+// process_info, process_state, osproc_children_list, osproctree). They read
+// /proc/[pid]/stat, status and cmdline through openat() on a /proc dirfd
+// opened once, into per-thread reusable buffers, and print the same table
+// the scripts get from ps. No bash, no ps: two fork/exec cycles less per call.
+//
+// Tools that need the whole process table share one ProcSnapshot, rescanned
+// at most once per TTL window. The previous scan is kept, so %CPU is the
+// real usage over the window between the two scans rather than ps's
+// lifetime average. When that scan is missing or older than a couple of
+// seconds, a fresh baseline is taken a moment before the new scan.
+//
+// osaudit_query is answered from the indexed audit store (audit_store.hpp).
+//
+// A tool opts in with "native": true in the manifest. Anything the native
+// path does not handle (odd arguments, /proc unavailable) falls back to the
+// script, so the scripts stay the reference implementation.
+//
+// =============================================================================
+
+/// One process as read from /proc
+struct ProcInfo {
+    int pid = 0;
+    int ppid = 0;
+    char state = '?';
+    std::string comm;
+    std::string cmdline;            // args joined by spaces; empty for kernel threads
+    unsigned long long utime = 0;   // clock ticks
+    unsigned long long stime = 0;
+    unsigned long long starttime = 0;
+    long rss_pages = 0;
+    uid_t euid = 0;
+};
+
+/// Reads /proc relative to a dirfd opened once for the process lifetime
+class ProcReader {
+public:
+    ProcReader();
+    ~ProcReader();
+    ProcReader(const ProcReader&) = delete;
+    ProcReader& operator=(const ProcReader&) = delete;
+
+    bool ok() const { return proc_fd >= 0; }
+
+    /// Fill info for pid; false if the process is gone or unreadable
+    bool read(int pid, ProcInfo& info, bool with_cmdline = true, bool with_uid = false) const;
+
+    /// All numeric entries of /proc in directory order
+    std::vector<int> pids() const;
+
+    double uptime() const;
+    unsigned long long memTotalKb() const;
+
+    /// "1m 5m 15m" from /proc/loadavg, empty if unavailable
+    std::string loadAverage() const;
+    long ticksPerSecond() const { return hertz; }
+    long pageKb() const { return page_kb; }
+
+    /// Width ps uses for PID columns (digits of pid_max - 1, at least 5)
+    int pidWidth() const { return pid_width; }
+
+private:
+    int proc_fd;
+    long hertz;
+    long page_kb;
+    int pid_width;
+
+    bool read_file(const char* rel_path, std::string& buf) const;
+};
+
+/// One scan of /proc. %CPU is measured against the scan before it.
+struct ProcSnapshot {
+    std::chrono::steady_clock::time_point taken;
+    double uptime = 0;
+    double window_s = 0;                 // time since the previous scan, 0 for the first
+    unsigned long long mem_total_kb = 0;
+    std::vector<ProcInfo> procs;         // /proc directory order
+    std::vector<double> cpu_pct;         // parallel to procs
+    std::unordered_map<int, size_t> by_pid;
+
+    /// Index into procs, or -1
+    long find(int pid) const;
+};
+
+/// Shared, TTL-cached /proc scans with delta CPU accounting
+class ProcSnapshotService {
+public:
+    /// Above this many PIDs a scan is split across threads
+    static constexpr size_t PARALLEL_MIN_PIDS = 4096;
+    /// Longest window %CPU is averaged over, and the one used instead
+    static constexpr std::chrono::milliseconds MAX_CPU_WINDOW{2000};
+    static constexpr std::chrono::milliseconds CPU_SAMPLE{200};
+
+    explicit ProcSnapshotService(const ProcReader& reader, int ttl_ms = 1000);
+
+    /// The current snapshot, rescanning if it is older than the TTL.
+    /// Concurrent callers share one rescan.
+    std::shared_ptr<const ProcSnapshot> get();
+
+    void setTtl(int ttl_ms);
+
+private:
+    const ProcReader& reader;
+    std::chrono::milliseconds ttl;
+    std::mutex scan_mutex;     // held for the duration of a rescan
+    std::mutex state_mutex;    // guards current
+    std::shared_ptr<const ProcSnapshot> current;
+
+    std::shared_ptr<const ProcSnapshot> scan(const std::shared_ptr<const ProcSnapshot>& previous) const;
+    std::vector<ProcInfo> read_range(const std::vector<int>& pids, size_t begin, size_t end) const;
+};
+
+namespace native_tools {
+
+/// Take the first snapshot in the background so a call soon after
+/// startup does not wait for the %CPU sample window
+void prime();
+
+/// Snapshot TTL in milliseconds (default 1000)
+void setSnapshotTtl(int ttl_ms);
+
+/// Run tool natively with its bound argv. Returns false when the tool has
+/// no native version or the arguments need the script's own handling.
+bool run(const std::string& tool, const std::vector<std::string>& args, std::string& output);
+
+} // namespace native_tools
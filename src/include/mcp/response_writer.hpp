@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+// =============================================================================
+// Response Writer (mcp_server side)
+// =============================================================================
+//
+// The single owner of the server's stdout. Workers hand over finished
+// JSON-RPC messages with send(); a dedicated thread writes everything that
+// has accumulated since its last wake-up with one writev() call, so several
+// responses completing together cost one syscall instead of one flush each.
+//
+// =============================================================================
+
+class ResponseWriter {
+public:
+    explicit ResponseWriter(int fd);
+    ~ResponseWriter();
+
+    /// Queue one message; a trailing newline is added on write
+    void send(std::string message);
+
+    /// Write everything still queued, then stop the writer thread
+    void shutdown();
+
+private:
+    int fd;
+    std::vector<std::string> pending;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+    std::thread thread;
+
+    void writer_loop();
+    void write_batch(const std::vector<std::string>& batch);
+};
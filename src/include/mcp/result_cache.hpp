@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+// =============================================================================
+// Tool Result Cache (mcp_server side)
+// =============================================================================
+//
+// LRU cache of tools/call results for read-only tools. Entries are keyed by
+// tool name plus the argv the manifest's argument mapping produced, so
+// {"pid": 1} and {"value": "1"} (or any key order / spacing) share an entry.
+//
+// A tool is cached only if its manifest entry has "safety": "read_only" and
+// a positive "cache_ttl_ms"; mutating and dangerous tools never are. The
+// cache is bounded by the bytes held in keys and results; the least recently
+// used entries are evicted first.
+//
+// =============================================================================
+
+class ResultCache {
+public:
+    explicit ResultCache(size_t max_bytes);
+
+    /// Cached result for tool/args if present and not expired; counts hit or miss
+    bool get(const std::string& tool, const std::vector<std::string>& args, std::string& result);
+
+    void put(const std::string& tool, const std::vector<std::string>& args,
+             const std::string& result, int ttl_ms);
+
+    /// {"hits":..,"misses":..,"hit_rate":..,"entries":..,"bytes":..,"max_bytes":..,
+    ///  "evictions":..,"tools":{"name":{"hits":..,"misses":..},...}}
+    std::string statsJson() const;
+
+    bool enabled() const { return max_bytes > 0; }
+
+private:
+    struct Entry {
+        std::string key;
+        std::string value;
+        std::chrono::steady_clock::time_point expires;
+    };
+    struct Counters {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    size_t max_bytes;
+    size_t bytes = 0;
+    std::list<Entry> lru;   // front = most recently used
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    Counters total;
+    std::map<std::string, Counters> per_tool;
+    uint64_t evictions = 0;
+    mutable std::mutex mutex;
+
+    static std::string make_key(const std::string& tool, const std::vector<std::string>& args);
+    static size_t cost(const Entry& e) { return e.key.size() + e.value.size() + 64; }
+    void erase(std::list<Entry>::iterator it);
+};
@@ -1,31 +1,59 @@
 #pragma once
 
+#include "mcp/transport.hpp"
 #include <string>
 #include <vector>
+#include <memory>
+#include <functional>
 
 class MCPServer {
 private:
-    int pid;
-    int stdin_pipe[2];
-    int stdout_pipe[2];
+    std::unique_ptr<MCPTransport> transport;
     int request_id;
     std::string server_name;
     std::vector<std::string> server_command;
+    std::string server_url;
+    int request_timeout_ms;
+    std::string last_error;   // why the last request produced no response
+    std::string last_resources; // _meta.resources of the last tools/call, if any
+    std::function<void(const std::string&)> progress_handler;
+    std::string progress_token;   // token of the tools/call in flight, "" if none
+    std::string progress_text;    // output streamed for it so far
+    int progress_seq = 0;
 
+    bool attach(std::unique_ptr<MCPTransport> t);
     bool initialize();
-    std::string sendRequest(const std::string& method, const std::string& params);
+    // timeout_ms <= 0 uses request_timeout_ms
+    std::string sendRequest(const std::string& method, const std::string& params, int timeout_ms = 0);
     void sendNotification(const std::string& method, const std::string& params);
-    std::string readResponse();
+    std::string readResponse(int id, Deadline deadline);
+    void cancelRequest(int id, const std::string& reason);
 
 public:
     MCPServer(const std::string& name);
     ~MCPServer();
 
+    // Local server spawned as a child process (stdio transport)
     bool connect(const std::vector<std::string>& command);
+    // Remote server reached over MCP streamable HTTP
+    bool connectRemote(const std::string& url);
+
     std::string listTools();
-    std::string callTool(const std::string& tool_name, const std::string& arguments,int exec_dangerous);
+    // Result of the ollmcpc-specific server/stats request; empty if unsupported
+    std::string getStats();
+    std::string callTool(const std::string& tool_name, const std::string& arguments,int exec_dangerous,
+                         int timeout_ms = 0);
+    // Resource cost the server measured for the last tool call (cgroups), or ""
+    std::string getLastResources() const { return last_resources; }
+    // While set, tools/call asks for notifications/progress and passes each
+    // streamed piece of output to handler as it arrives
+    void setProgressHandler(std::function<void(const std::string&)> handler) { progress_handler = std::move(handler); }
     void disconnect();
 
+    void setTimeout(int ms) { if (ms > 0) request_timeout_ms = ms; }
+    int getTimeout() const { return request_timeout_ms; }
+
     std::string getName() const { return server_name; }
     std::vector<std::string> getCommand() const { return server_command; }
+    std::string getUrl() const { return server_url; }
 };
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "mcp/tool_exec.hpp"
+#include "mcp/tool_registry.hpp"
+#include "mcp/tool_cgroups.hpp"
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <sys/types.h>
+
+// =============================================================================
+// Shell Session (mcp_server side)
+// =============================================================================
+//
+// With --shell-session, "run": "command" tools (run_shell_command) go to one
+// long-lived bash coprocess instead of a fresh dispatcher per call, so cd,
+// exported variables and shell functions carry over between calls and
+// repeated commands skip the process startup.
+//
+// The shell reads commands from a pipe; its stdout and stderr share another.
+// Each command is sent as one framed line:
+//
+//   __mcp_run_n '<command>' </dev/null 2>&1; printf '\n%s %d\n' <marker> $?
+//
+// and its output is everything up to the per-session marker line, which
+// also carries the exit status. The dispatcher's policy still applies: a
+// DEBUG trap (extdebug) looks at every simple command the shell is about to
+// run, including ones in functions, loops and $(...), and asks
+// "dispatcher --check -y|-n <name>" for the commands the policy table
+// (dispatch_policy.c) lists. The trap sees the command text before
+// expansion, so a name that only expansion reveals ($c, $(...), globs,
+// brace lists) is refused outright. A refused command is skipped with the
+// dispatcher's message, and the call returns an error. Internal dispatcher
+// commands (sched, wipe) are shell functions that call the dispatcher.
+//
+// The command cannot turn the checks off: their variables and functions are
+// readonly, -y or -n is which of __mcp_run_y / __mcp_run_n it runs in, the
+// trap calls nothing the command could redefine, and the builtins that
+// could remove the trap (trap, set, shopt, unset, enable, builtin) are
+// refused. Since the command runs inside __mcp_run_*, a plain declare in it
+// is local to that call; declare -g keeps a variable for later calls.
+//
+// Commands run one at a time. The tool's timeout_ms and max_output_bytes
+// apply per command; when a command is stopped by one, or cancelled, the
+// whole session is killed and the next command starts a new one. With
+// cgroups the session lives in one cgroup with the tool's limits.
+//
+// =============================================================================
+
+class ShellSession {
+public:
+    ShellSession(const std::string& dispatcher_path, ToolCgroups& cgroups);
+    ~ShellSession();
+    ShellSession(const ShellSession&) = delete;
+    ShellSession& operator=(const ShellSession&) = delete;
+
+    /// Run command in the session, starting it if needed, with tool's limits.
+    /// exit_status is the command's status, or -1 if the session ended;
+    /// refused is set if the checks refused any part of the command.
+    /// Returns false if the shell could not be started (nothing was run).
+    bool run(const ToolMeta& tool, const std::string& command, bool exec_dangerous,
+             std::string& output, const CancelToken* cancel, tool_exec::Outcome* outcome = nullptr,
+             int* exit_status = nullptr, bool* refused = nullptr, const tool_exec::OutputSink& sink = nullptr);
+
+    /// Kill the shell and everything it started
+    void stop();
+
+    /// {"running":..,"started":..,"commands":..,"killed":..}
+    std::string statsJson() const;
+
+private:
+    std::string dispatcher_path;
+    ToolCgroups& cgroups;
+
+    pid_t pid = -1;               // the shell, also its process group; -1 when not running
+    int in_fd = -1;               // shell's stdin
+    int out_fd = -1;              // shell's stdout + stderr
+    std::string marker;           // ends each command's output
+    std::string cgroup;           // the session's cgroup, if any
+    std::string refused_dir;      // private to the session
+    std::string refused_file;     // in refused_dir; created when the checks refuse a command
+    std::mutex mutex;             // one command at a time; guards all of the above
+
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> started{0};
+    std::atomic<uint64_t> commands{0};
+    std::atomic<uint64_t> killed{0};
+
+    bool start(const ToolMeta& tool);   // caller holds mutex
+    void shutdown();                    // caller holds mutex
+    std::string init_script() const;
+    tool_exec::Outcome collect(std::string& output, int& exit_status, const CancelToken* cancel,
+                               const tool_exec::Limits& limits, const tool_exec::OutputSink& sink);
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+// =============================================================================
+// Tool cgroups (mcp_server side)
+// =============================================================================
+//
+// With --cgroups, every script run gets a transient cgroup v2 child:
+//
+//   <root>/mcp_server          mcp_server itself (moved here at startup)
+//   <root>/tool-<name>-<n>     one per run, removed afterwards
+//
+// The dispatcher joins the child before the policy check (--cgroup DIR, or
+// the cgroup field of a zygote job), so the script and everything it forks
+// are accounted there. Limits come from the manifest (cpu_weight,
+// memory_max, io_weight, io_max) and are applied when the controller is
+// delegated to <root>. After the run, cpu.stat, memory.peak and io.stat
+// are read back into a ResourceUsage.
+//
+// <root> is the cgroup mcp_server starts in, or --cgroup-root DIR. Without
+// cgroup v2, or without write access to <root>, init() fails and tools run
+// as before. Without delegated controllers, limits are skipped and only
+// CPU time is measured.
+//
+// =============================================================================
+
+/// Manifest resource limits for one tool; zero / empty = not set
+struct CgroupLimits {
+    int cpu_weight = 0;          // cpu.weight, 1..10000 (default 100)
+    std::string memory_max;      // memory.max, e.g. "256M"
+    int io_weight = 0;           // io.weight, 1..10000 (default 100)
+    std::string io_max;          // io.max line, e.g. "8:0 rbps=10485760"
+};
+
+/// What one run cost, read back from its cgroup
+struct ResourceUsage {
+    bool valid = false;
+    uint64_t cpu_usec = 0;
+    uint64_t user_usec = 0;
+    uint64_t system_usec = 0;
+    uint64_t memory_peak = 0;    // bytes, 0 if memory is not delegated
+    uint64_t io_read = 0;        // bytes, 0 if io is not delegated
+    uint64_t io_write = 0;
+
+    /// {"cpu_ms":..,"user_ms":..,"system_ms":..,"memory_peak_kb":..,"io_read_kb":..,"io_write_kb":..}
+    std::string json() const;
+};
+
+class ToolCgroups {
+public:
+    /// Set up <root>; root_dir empty = the cgroup this process is in.
+    /// Returns false (and logs why) when cgroups cannot be used.
+    bool init(const std::string& root_dir = "");
+    bool available() const { return !root.empty(); }
+
+    /// Create the cgroup for one run of tool with limits applied.
+    /// Returns its directory, or "" if it could not be created.
+    std::string create(const std::string& tool, const CgroupLimits& limits);
+
+    /// Read the run's usage, then remove its cgroup (killing stragglers)
+    ResourceUsage finish(const std::string& dir);
+
+    /// {"available":..,"root":..,"controllers":..,"reason":..}
+    std::string statusJson() const;
+
+private:
+    std::string root;            // empty while unavailable
+    std::string controllers;     // enabled in <root>/cgroup.subtree_control
+    std::string reason;          // why cgroups are unavailable
+    std::atomic<uint64_t> seq{0};
+
+    bool has_controller(const std::string& name) const;
+};
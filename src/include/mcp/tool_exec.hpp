@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <functional>
+#include <sys/types.h>
+
+// =============================================================================
+// Tool Process Execution (mcp_server side)
+// =============================================================================
+//
+// Runs one tool invocation as a child process: spawned directly with
+// posix_spawn (no /bin/sh hop), in its own process group, stdin on /dev/null,
+// stdout collected into a string. A CancelToken lets another thread stop the
+// whole process group while a worker is blocked reading its output, and
+// Limits stop it the same way when it runs too long or prints too much.
+//
+// =============================================================================
+
+/// Thread-safe, one-shot cancellation flag with a pollable fd (eventfd)
+class CancelToken {
+private:
+    std::atomic<bool> flag;
+    int event_fd;
+
+public:
+    CancelToken();
+    ~CancelToken();
+    CancelToken(const CancelToken&) = delete;
+    CancelToken& operator=(const CancelToken&) = delete;
+
+    void cancel();
+    bool cancelled() const { return flag.load(); }
+
+    /// Becomes readable once cancel() has been called
+    int fd() const { return event_fd; }
+};
+
+namespace tool_exec {
+
+/// Grace period between SIGTERM and SIGKILL for a stopped process group
+constexpr int KILL_GRACE_MS = 2000;
+
+/// Per-run limits, 0 = unlimited
+struct Limits {
+    int timeout_ms = 0;             // wall clock from the start of collection
+    size_t max_output_bytes = 0;    // output beyond this is discarded
+};
+
+/// Receives output as it is read, before collect() returns
+using OutputSink = std::function<void(const char* data, size_t len)>;
+
+/// Why collection ended
+enum class Outcome {
+    Completed,     // EOF without intervention
+    Cancelled,     // the CancelToken fired
+    TimedOut,      // Limits::timeout_ms passed
+    OutputLimit    // Limits::max_output_bytes reached
+};
+
+/// Split a command line into words like a shell tokenizer would
+/// (whitespace, '...' and "..." quoting, backslash escapes), no expansion.
+std::vector<std::string> split_command_words(const std::string& line);
+
+/// Spawn argv[0] (searched in PATH) with argv and collect its stdout into output.
+/// If cancel fires or a limit is hit, the process group gets SIGTERM, then
+/// SIGKILL after KILL_GRACE_MS; output keeps what was read until then.
+/// Returns false only when the process could not be spawned.
+bool run(const std::vector<std::string>& argv, std::string& output, const CancelToken* cancel = nullptr,
+         const Limits& limits = Limits(), Outcome* outcome = nullptr, const OutputSink& sink = nullptr);
+
+/// Read out_fd to EOF into output, then close it. Every piece kept is also
+/// passed to sink, if set. On cancel or a limit, process group pgid is
+/// stopped as described for run(). Does not reap.
+Outcome collect(int out_fd, pid_t pgid, std::string& output, const CancelToken* cancel,
+                const Limits& limits = Limits(), const OutputSink& sink = nullptr);
+
+} // namespace tool_exec
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "mcp/tool_cgroups.hpp"
+#include "mcp/arg_binder.hpp"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <ctime>
+
+// =============================================================================
+// Tool Registry (mcp_server side)
+// =============================================================================
+//
+// Tool definitions live in <tools_directory>/manifest.json instead of being
+// compiled in, so a new script only needs a manifest entry:
+//
+//   {"tools": [{
+//       "name": "process_info",              // MCP tool name
+//       "script": "process_info.sh",         // file in tools_directory
+//       "description": "...",
+//       "inputSchema": {...},                // sent verbatim in tools/list
+//       "args": [{"key": "pid", "aliases": ["value"]}],
+//       "run": "script",                     // or "command" (see below)
+//       "safety": "read_only",               // read_only | mutating | dangerous
+//       "timeout_ms": 10000,                 // wall clock, then the process group is killed
+//       "max_output_bytes": 1048576,         // output cap, same kill on overflow
+//       "cpu_weight": 50, "memory_max": "256M",   // cgroup limits with --cgroups
+//       "io_weight": 50, "io_max": "8:0 rbps=10485760",
+//       "cache_ttl_ms": 2000,                // read_only tools only, 0 = never cached
+//       "max_concurrent": 0,                 // 0 = no per-tool limit
+//       "native": true,                      // built-in /proc version (native_tools.hpp)
+//       "stream": true,                      // forward output as notifications/progress
+//       "enabled": true
+//   }]}
+//
+// "args" maps JSON arguments onto the script's argv in order. Each entry may
+// carry "aliases", a "flag" emitted before the value (e.g. "--lines"),
+// "switch": true for boolean flags, and "required": true. Together with the
+// inputSchema types it is compiled into the tool's ArgBinder at load.
+// With "run": "command" the dispatcher runs the words of the argument itself
+// instead of a script (run_shell_command).
+//
+// Lookups go through a hash map and the tools/list result is serialized once
+// per load. The manifest's mtime is checked at most once per second and a
+// changed file is reloaded in place; callers keep the snapshot they hold.
+//
+// =============================================================================
+
+struct ToolMeta {
+    std::string name;
+    std::string script;
+    std::string description;
+    std::string inputSchema;
+    std::vector<ToolArg> args;
+    ArgBinder binder;        // args + inputSchema, compiled
+    std::string run = "script";
+    std::string safety = "read_only";
+    int timeout_ms = 30000;
+    size_t max_output_bytes = 1024 * 1024;
+    CgroupLimits cgroup;
+    int max_concurrent = 0;
+    int cache_ttl_ms = 0;
+    bool native = false;
+    bool stream = false;
+
+    /// Results may be served from ResultCache
+    bool cacheable() const { return safety == "read_only" && run != "command" && cache_ttl_ms > 0; }
+};
+
+class ToolRegistry {
+public:
+    explicit ToolRegistry(const std::string& manifest_path);
+
+    /// Parse the manifest; on failure the previous tool set stays active
+    bool load();
+
+    /// Reload when the manifest changed on disk. Returns true if it did.
+    bool reloadIfChanged();
+
+    /// nullptr if unknown; the pointer stays valid across reloads
+    std::shared_ptr<const ToolMeta> find(const std::string& name) const;
+
+    /// Prebuilt result object for tools/list
+    std::string toolsListResult() const;
+
+    std::vector<std::shared_ptr<const ToolMeta>> all() const;
+
+    const std::string& path() const { return manifest_path; }
+
+private:
+    struct Snapshot {
+        std::vector<std::shared_ptr<const ToolMeta>> ordered;
+        std::unordered_map<std::string, std::shared_ptr<const ToolMeta>> by_name;
+        std::string tools_list;
+    };
+
+    std::string manifest_path;
+    std::shared_ptr<const Snapshot> snapshot;
+    mutable std::mutex mutex;
+    std::time_t loaded_mtime = 0;
+    std::time_t last_check = 0;
+
+    std::shared_ptr<const Snapshot> current() const;
+    static ToolMeta parse_tool(const std::string& obj);
+};
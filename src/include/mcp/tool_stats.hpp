@@ -0,0 +1,56 @@
+#pragma once
+
+#include "mcp/tool_exec.hpp"
+#include "mcp/tool_cgroups.hpp"
+#include <string>
+#include <map>
+#include <mutex>
+#include <cstdint>
+
+// =============================================================================
+// Tool Execution Stats (mcp_server side)
+// =============================================================================
+//
+// Per-tool timing of tools/call requests, split into the time a request
+// waited on the worker pool queue and the time spent executing it, so a
+// slow tool and an undersized pool can be told apart in server/stats.
+// Runs stopped by their time or output limit are counted per tool too, and
+// with --cgroups the CPU time and peak memory each tool costs.
+//
+// =============================================================================
+
+class ToolStats {
+public:
+    void record(const std::string& tool, double queue_ms, double exec_ms,
+                tool_exec::Outcome outcome = tool_exec::Outcome::Completed);
+
+    /// Resource cost of one run, measured in its cgroup
+    void recordUsage(const std::string& tool, const ResourceUsage& usage);
+
+    /// {"calls":..,"queue_ms_avg":..,"queue_ms_max":..,"exec_ms_avg":..,"exec_ms_max":..,
+    ///  "timeouts":..,"timeout_rate":..,"output_limited":..,
+    ///  ["measured":..,"cpu_ms_avg":..,"cpu_ms_total":..,"memory_peak_kb_max":..,]
+    ///  "tools":{"name":{...same fields...},...}}
+    std::string statsJson() const;
+
+private:
+    struct Timing {
+        uint64_t calls = 0;
+        double queue_ms_total = 0;
+        double queue_ms_max = 0;
+        double exec_ms_total = 0;
+        double exec_ms_max = 0;
+        uint64_t timeouts = 0;
+        uint64_t output_limited = 0;
+        uint64_t measured = 0;           // runs with a ResourceUsage
+        uint64_t cpu_usec_total = 0;
+        uint64_t memory_peak_max = 0;
+
+        void add(double queue_ms, double exec_ms, tool_exec::Outcome outcome);
+        std::string fields() const;
+    };
+
+    Timing total;
+    std::map<std::string, Timing> per_tool;
+    mutable std::mutex mutex;
+};
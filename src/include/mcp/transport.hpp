@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+// =============================================================================
+// MCP Transports
+// =============================================================================
+//
+// A transport moves single-line JSON-RPC messages between the client and one
+// MCP server. MCPServer owns exactly one transport and does not care whether
+// the server is a local child process or a remote HTTP endpoint.
+//
+//   StdioTransport - child process, newline-delimited JSON on stdin/stdout
+//   HttpTransport  - MCP streamable HTTP (see mcp/http_transport.hpp)
+//
+// =============================================================================
+
+using Deadline = std::chrono::steady_clock::time_point;
+
+enum class RecvStatus {
+    Line,     // a line was received
+    Timeout,  // deadline reached, nothing received yet
+    Closed    // nothing more can arrive (EOF, drained HTTP reply)
+};
+
+class MCPTransport {
+public:
+    virtual ~MCPTransport() = default;
+
+    /// Establish the connection (spawn the child / open the HTTP session)
+    virtual bool open() = 0;
+
+    /// Send one JSON-RPC message (without trailing newline).
+    /// Transports that wait for the reply inside send() honour the deadline,
+    /// and Ctrl-C aborts that wait only when abortable is set.
+    virtual bool send(const std::string& message, Deadline deadline, bool abortable) = 0;
+
+    /// Wait until the deadline for the next line received from the server
+    virtual RecvStatus receive(std::string& line, Deadline deadline) = 0;
+
+    virtual void close() = 0;
+
+    /// Short human readable description for logs and /servers
+    virtual std::string describe() const = 0;
+};
+
+class StdioTransport : public MCPTransport {
+private:
+    std::vector<std::string> command;
+    int pid;
+    int stdin_pipe[2];
+    int stdout_pipe[2];
+    std::string read_buffer;
+
+public:
+    StdioTransport(const std::vector<std::string>& command);
+    ~StdioTransport() override;
+
+    bool open() override;
+    bool send(const std::string& message, Deadline deadline, bool abortable) override;
+    RecvStatus receive(std::string& line, Deadline deadline) override;
+    void close() override;
+    std::string describe() const override;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+// =============================================================================
+// Worker Pool (mcp_server side)
+// =============================================================================
+//
+// Fixed set of threads that run tools/call jobs concurrently. Every job has a
+// key (the tool name); setLimit() caps how many jobs with the same key may
+// run at once. Jobs over their limit stay queued and later jobs for other
+// tools overtake them, so one slow tool never blocks the rest.
+//
+// =============================================================================
+
+class WorkerPool {
+public:
+    using Job = std::function<void()>;
+
+    explicit WorkerPool(size_t threads);
+    ~WorkerPool();
+
+    /// Max concurrently running jobs for key (<= 0 removes the limit)
+    void setLimit(const std::string& key, int max_concurrent);
+
+    void submit(const std::string& key, Job job);
+
+    /// Finish queued and running jobs, then join all threads
+    void shutdown();
+
+    size_t size() const { return threads.size(); }
+
+private:
+    struct Entry {
+        std::string key;
+        Job job;
+    };
+
+    std::vector<std::thread> threads;
+    std::deque<Entry> queue;
+    std::map<std::string, int> limits;
+    std::map<std::string, int> running;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+
+    void worker_loop();
+    bool runnable(const std::string& key) const;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "mcp/tool_exec.hpp"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <sys/types.h>
+
+// =============================================================================
+// Zygote Worker Pool (mcp_server side)
+// =============================================================================
+//
+// Keeps pre-forked dispatcher workers warm so a tool call does not pay for
+// spawning, exec'ing and dynamically linking the dispatcher every time.
+//
+//   mcp_server --(control socket)--> dispatcher --zygote
+//                                       | fork, no exec
+//                                       v
+//   mcp_server <----(job socket)---- warm worker --fork--> policy + script
+//
+// start() launches the zygote and asks it for the initial warm workers.
+// Each job goes to an idle worker over its SOCK_SEQPACKET socket together
+// with the write end of the output pipe. The worker reports the job's
+// process group, so cancellation and limits work as with tool_exec::run().
+// A worker is retired after max_jobs jobs or on any protocol failure, and
+// the zygote forks its replacement.
+//
+// If the zygote cannot be started or dies, run() returns false and the
+// caller falls back to tool_exec::run().
+//
+// =============================================================================
+
+class ZygotePool {
+public:
+    /// warm: workers forked up front; max_jobs: jobs per worker before recycling
+    ZygotePool(const std::string& dispatcher_path, size_t warm, int max_jobs);
+    ~ZygotePool();
+    ZygotePool(const ZygotePool&) = delete;
+    ZygotePool& operator=(const ZygotePool&) = delete;
+
+    bool start();
+
+    /// What the worker does before running a job
+    enum class Policy {
+        Refuse,     // dispatcher policy, dangerous commands refused (-n)
+        Approve,    // dispatcher policy, dangerous commands approved (-y)
+        Checked     // decided in-process already: exec the program directly
+    };
+
+    /// Run "dispatcher [--cgroup DIR] -y|-n program args..." on a warm worker,
+    /// or just the program for Policy::Checked.
+    /// Returns false if no worker could take the job (nothing was run).
+    bool run(Policy policy, const std::vector<std::string>& program_and_args,
+             std::string& output, const CancelToken* cancel,
+             const tool_exec::Limits& limits = tool_exec::Limits(),
+             tool_exec::Outcome* outcome = nullptr, const std::string& cgroup = "",
+             const tool_exec::OutputSink& sink = nullptr);
+
+    /// {"warm":..,"idle":..,"spawned":..,"recycled":..,"failed":..,"jobs":..}
+    std::string statsJson() const;
+
+private:
+    struct Worker {
+        pid_t pid = -1;
+        int sock = -1;
+        int jobs = 0;
+    };
+
+    std::string dispatcher_path;
+    size_t warm;
+    int max_jobs;
+
+    pid_t zygote_pid = -1;
+    int ctl = -1;                 // control socket to the zygote, -1 when unavailable
+    std::vector<Worker> idle;
+    mutable std::mutex mutex;     // guards ctl, idle and the counters
+
+    uint64_t spawned = 0;
+    uint64_t recycled = 0;
+    uint64_t failed = 0;
+    uint64_t jobs = 0;
+
+    bool spawn_worker(Worker& worker);   // caller holds mutex
+    bool acquire(Worker& worker);
+    void release(Worker& worker, bool healthy);
+    void retire(Worker& worker);
+};
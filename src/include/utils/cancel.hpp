@@ -0,0 +1,36 @@
+#pragma once
+#include <csignal>
+
+namespace utils {
+    // Scoped Ctrl-C handling for long-running calls.
+    // While a CancelScope is alive, SIGINT only raises a flag instead of
+    // killing the client, so blocking loops can poll requested() and abort
+    // the current operation cleanly. The previous handler is restored on exit.
+    class CancelScope {
+    private:
+        struct sigaction previous;
+        static inline volatile std::sig_atomic_t flag = 0;
+
+        static void on_sigint(int) { flag = 1; }
+
+    public:
+        CancelScope() {
+            flag = 0;
+            struct sigaction sa = {};
+            sa.sa_handler = on_sigint;
+            sigemptyset(&sa.sa_mask);
+            sa.sa_flags = 0; // no SA_RESTART: let poll()/read() return EINTR
+            sigaction(SIGINT, &sa, &previous);
+        }
+
+        ~CancelScope() {
+            sigaction(SIGINT, &previous, nullptr);
+            flag = 0;
+        }
+
+        CancelScope(const CancelScope&) = delete;
+        CancelScope& operator=(const CancelScope&) = delete;
+
+        static bool requested() { return flag != 0; }
+    };
+}
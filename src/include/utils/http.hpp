@@ -1,11 +1,84 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <functional>
+#include <future>
+#include <cstdint>
+
+// =============================================================================
+// HTTP Client (LLM providers)
+// =============================================================================
+//
+// Blocking POSTs over a pool of libcurl easy handles, kept per host
+// (scheme://host:port) and reused across calls, so each agent loop step
+// finds a live keep-alive connection instead of paying TCP, TLS and DNS
+// again. All handles share one curl share handle for the DNS cache, TLS
+// sessions and the connection cache. HTTP/2 is negotiated on https URLs.
+//
+// Handles are thread-safe to borrow; each request holds its own.
+//
+// postAsync()/postFuture() run requests concurrently on one event loop
+// thread: a curl multi handle driven by curl_multi_socket_action, with
+// epoll watching the sockets curl asks for and its timer as the epoll
+// timeout. Completion and chunk callbacks run on that thread, so they must
+// not block on another async request. The thread starts with the first
+// async request and stops in closeAll().
+//
+// =============================================================================
 
 class HTTPClient {
 private:
     static size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp);
+    static size_t stream_callback(void* contents, size_t size, size_t nmemb, void* userp);
 
 public:
+    /// Receives the response body piece by piece; return false to abort
+    using ChunkHandler = std::function<bool(const char* data, size_t len)>;
+
+    /// Outcome of an async request
+    struct Response {
+        long status = 0;           // HTTP status, 0 if none arrived
+        std::string body;          // empty when the body went to a ChunkHandler
+        std::string error;         // curl's message, "cancelled" after cancel()
+        long total_ms = 0;         // how long the transfer took
+        bool ok() const { return error.empty(); }
+    };
+    using DoneHandler = std::function<void(const Response& response)>;
+    using RequestId = uint64_t;
+
     static std::string post(const std::string& url, const std::string& data);
+
+    /// post() for streamed responses: on_chunk sees the body as it arrives.
+    /// Instead of the total timeout, the stream fails after that long
+    /// without any data. Returns false if the transfer failed or was aborted.
+    static bool postStream(const std::string& url, const std::string& data, const ChunkHandler& on_chunk);
+
+    /// Start a POST on the event loop and return at once. on_done runs when
+    /// it finishes, fails or is cancelled; with on_chunk the body is streamed
+    /// as in postStream() and Response::body stays empty.
+    static RequestId postAsync(const std::string& url, const std::string& data,
+                               DoneHandler on_done, ChunkHandler on_chunk = nullptr);
+
+    /// postAsync() with a future; id, if given, is set for cancel()
+    static std::future<Response> postFuture(const std::string& url, const std::string& data,
+                                            RequestId* id = nullptr);
+
+    /// POST each body to url at once; the responses come back in order.
+    /// Ctrl-C (a live utils::CancelScope) cancels the ones still running.
+    static std::vector<Response> postAll(const std::string& url, const std::vector<std::string>& bodies);
+
+    /// Abort an async request mid-flight; false if it already finished
+    static bool cancel(RequestId id);
+
+    /// Connect and total timeouts for every later request (default 10 s, 120 s)
+    static void setTimeouts(long connect_ms, long total_ms);
+
+    /// {"requests":..,"connections":..,"reused":..,"http2":..,"handles":..,"idle":..,
+    ///  "hosts":{"https://host":{"requests":..,"connections":..},...}}
+    static std::string statsJson();
+
+    /// Stop the event loop (cancelling what is in flight) and free the
+    /// pooled handles; call before curl_global_cleanup()
+    static void closeAll();
 };
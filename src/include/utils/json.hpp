@@ -70,6 +70,16 @@ namespace json {
         
         /// Extract array of strings: {"key": ["a", "b"]} -> ["a", "b"]
         std::vector<std::string> get_string_array(const std::string& json, const std::string& key);
+        
+        /// Top-level members of an object, values as raw JSON text:
+        /// {"a": 1, "b": {"c": 2}} -> [("a", "1"), ("b", "{\"c\": 2}")]
+        std::vector<std::pair<std::string, std::string>> members(const std::string& json);
+        
+        /// Top-level items of an array as raw JSON text: [1, {"a": 2}] -> ["1", "{\"a\": 2}"]
+        std::vector<std::string> items(const std::string& json);
+        
+        /// Plain text of a raw scalar: "\"x\"" -> "x" (unescaped), "42" -> "42", "true" -> "true"
+        std::string scalar(const std::string& raw);
     }
 }
 
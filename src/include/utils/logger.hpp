@@ -3,6 +3,7 @@
 #include <fstream>
 #include <iostream>
 #include <ctime>
+#include <mutex>
 
 namespace utils {
     class Logger {
@@ -16,6 +17,9 @@ namespace utils {
 
     public:
         static void log(const std::string& level, const std::string& message) {
+            // mcp_server logs from several worker threads
+            static std::mutex mutex;
+            std::lock_guard<std::mutex> lock(mutex);
             std::ofstream file("debug.log", std::ios::app);
             if (file.is_open()) {
                 file << "[" << get_timestamp() << "] [" << level << "] " << message << "\n";
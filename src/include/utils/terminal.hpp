@@ -38,6 +38,30 @@ namespace term {
     };
 
     void draw_box(const std::string& title, const std::string& content, const std::string& color);
+
+    /// draw_box() for content that arrives in pieces (streamed tool output).
+    /// The top border is drawn on the first write, each line as soon as it is
+    /// complete, and the rest plus the bottom border on close(). With
+    /// show_partial, the unfinished last line is shown too and redrawn as it
+    /// grows (for replies streamed token by token).
+    class LiveBox {
+    public:
+        LiveBox(const std::string& title, const std::string& color, bool show_partial = false)
+            : title(title), color(color), show_partial(show_partial) {}
+        ~LiveBox() { close(); }
+        void write(const std::string& text);
+        void close();
+        bool opened() const { return is_open || is_closed; }
+
+    private:
+        std::string title;
+        std::string color;
+        bool show_partial;
+        std::string pending;   // partial last line
+        bool partial_shown = false;
+        bool is_open = false;
+        bool is_closed = false;
+    };
     void print_thought(const std::string& thought);
     void display_tool_menu(const std::vector<ToolInfo>& tools);
 }
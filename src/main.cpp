@@ -3,9 +3,11 @@
 #include "llm/provider_factory.hpp"
 #include "app/interactive.hpp"
 #include "utils/terminal.hpp"
+#include "utils/http.hpp"
 #include <iostream>
 #include <string>
 #include <vector>
+#include <future>
 #include <curl/curl.h>
 
 void show_help() {
@@ -57,6 +59,7 @@ int main(int argc, char** argv) {
     if (command == "serve") {
         // Init Curl
         curl_global_init(CURL_GLOBAL_DEFAULT);
+        HTTPClient::setTimeouts(config.http_connect_timeout_ms, config.http_timeout_ms);
         
         // Disable buffering for instant TUI
         setvbuf(stdout, NULL, _IONBF, 0);
@@ -80,6 +83,10 @@ int main(int argc, char** argv) {
             return 1;
         }
 
+        // Load the model while the MCP servers start instead of on the first chat
+        std::future<ChatResponse> warm_up;
+        if (config.ollama_preload) warm_up = provider->warmUp();
+
         // Create Client
         MCPClient client(std::move(provider));
         client.human_in_loop = config.human_in_loop;
@@ -87,22 +94,51 @@ int main(int argc, char** argv) {
         std::cout << "🔌 Connecting to MCP servers...\n";
         
         // Always add the "os-assistant" server which corresponds to our mcp_server binary
-        client.addServer("os-assistant", {"mcp_server"});
+        std::vector<std::string> os_assistant = {"mcp_server", "--workers", std::to_string(config.server_workers),
+                                                 "--cache-mb", std::to_string(config.server_cache_mb),
+                                                 "--zygote-workers", std::to_string(config.server_zygote_workers),
+                                                 "--worker-jobs", std::to_string(config.server_worker_max_jobs)};
+        for (const auto& limit : config.tool_limits) {
+            os_assistant.push_back("--max-concurrent");
+            os_assistant.push_back(limit);
+        }
+        if (!config.server_cgroup_root.empty()) {
+            os_assistant.push_back("--cgroup-root");
+            os_assistant.push_back(config.server_cgroup_root);
+        } else if (config.server_cgroups) {
+            os_assistant.push_back("--cgroups");
+        }
+        if (config.server_shell_session) os_assistant.push_back("--shell-session");
+        client.addServer("os-assistant", os_assistant);
  
 
         // Add Configured Servers
         for (const auto& s : config.servers) {
-            if (s.enabled) {
-                client.addServer(s.name, s.command);
+            if (s.enabled && s.transport == "http") {
+                client.addRemoteServer(s.name, s.url, s.timeout_ms);
+            } else if (s.enabled) {
+                client.addServer(s.name, s.command, s.timeout_ms);
             } else {
                 std::cout << "  " << term::DIM << "○ Skipping disabled server: " << s.name << term::RESET << "\n";
             }
         }
 
+        if (warm_up.valid()) {
+            std::cout << "⏳ Waiting for " << client.getLLM()->name() << " to load the model...\n";
+            ChatResponse loaded = warm_up.get();
+            if (loaded.error.empty()) {
+                std::cout << "  " << term::GREEN << "✓ Model ready" << term::RESET << " " << term::DIM
+                          << "(load " << (long)loaded.load_ms << " ms)" << term::RESET << "\n";
+            } else {
+                std::cout << "  " << term::YELLOW << "○ Model warm-up failed: " << loaded.error << term::RESET << "\n";
+            }
+        }
+
         // Start Loop
         app::run_interactive_session(client);
 
         std::cout << "\n👋 Goodbye!\n";
+        HTTPClient::closeAll();
         curl_global_cleanup();
         return 0;
     }
@@ -1,8 +1,11 @@
 #include "app/config.hpp"
 #include "utils/json.hpp"
 #include "utils/terminal.hpp"
+#include "utils/logger.hpp"
 #include <iostream>
 #include <fstream>
+#include <cerrno>
+#include <climits>
 #include <cstdlib>
 #include <unistd.h>
 #include <pwd.h>
@@ -16,6 +19,20 @@ std::string get_config_path() {
     return std::string(home ? home : ".") + "/.ollmcpc.json";
 }
 
+// Set value from an integer key; a value that does not fit an int keeps the default
+static void read_int(const std::string& json, const std::string& key, int& value) {
+    std::string raw = json::parse::get_raw_value(json, "\"" + key + "\":");
+    if (raw.empty()) return;
+    char* end = nullptr;
+    errno = 0;
+    long long parsed = std::strtoll(raw.c_str(), &end, 10);
+    if (*end != '\0' || errno == ERANGE || parsed < INT_MIN || parsed > INT_MAX) {
+        utils::Logger::error("Config: " + key + " = " + raw + " is out of range, keeping " + std::to_string(value));
+        return;
+    }
+    value = (int)parsed;
+}
+
 Config Config::load_default() {
     Config config;
     std::string path = get_config_path();
@@ -30,12 +47,26 @@ Config Config::load_default() {
     
     std::string omodel = json::parse::get_string(content, "ollama_model");
     if (!omodel.empty()) config.ollama_model = omodel;
+
+    if (content.find("\"ollama_preload\": false") != std::string::npos ||
+        content.find("\"ollama_preload\":false") != std::string::npos) {
+        config.ollama_preload = false;
+    }
+    if (content.find("\"ollama_keep_alive\":") != std::string::npos) {
+        config.ollama_keep_alive = json::parse::get_string(content, "ollama_keep_alive");
+    }
+    read_int(content, "ollama_num_ctx", config.ollama_num_ctx);
+    read_int(content, "ollama_num_thread", config.ollama_num_thread);
+    read_int(content, "ollama_num_batch", config.ollama_num_batch);
     
     std::string gkey = json::parse::get_string(content, "gemini_api_key");
     if (!gkey.empty()) config.gemini_api_key = gkey;
 
     std::string gmodel = json::parse::get_string(content, "gemini_model");
     if (!gmodel.empty()) config.gemini_model = gmodel;
+
+    std::string gurl = json::parse::get_string(content, "gemini_url");
+    if (!gurl.empty()) config.gemini_url = gurl;
     
     // HIL
     if (content.find("\"human_in_loop\": false") != std::string::npos || 
@@ -45,6 +76,20 @@ Config Config::load_default() {
         config.human_in_loop = true;
     }
     
+    read_int(content, "http_connect_timeout_ms", config.http_connect_timeout_ms);
+    read_int(content, "http_timeout_ms", config.http_timeout_ms);
+
+    read_int(content, "server_workers", config.server_workers);
+    config.tool_limits = json::parse::get_string_array(content, "tool_limits");
+    read_int(content, "server_cache_mb", config.server_cache_mb);
+    read_int(content, "server_zygote_workers", config.server_zygote_workers);
+    read_int(content, "server_worker_max_jobs", config.server_worker_max_jobs);
+    config.server_cgroups = content.find("\"server_cgroups\": true") != std::string::npos ||
+                            content.find("\"server_cgroups\":true") != std::string::npos;
+    config.server_cgroup_root = json::parse::get_string(content, "server_cgroup_root");
+    config.server_shell_session = content.find("\"server_shell_session\": true") != std::string::npos ||
+                                  content.find("\"server_shell_session\":true") != std::string::npos;
+
     // Servers
     std::string servers_arr = json::parse::get_array(content, "servers");
     if (!servers_arr.empty() && servers_arr != "[]") {
@@ -58,6 +103,11 @@ Config Config::load_default() {
                 MCPServerConfig s;
                 s.name = json::parse::get_string(obj, "name");
                 s.command = json::parse::get_string_array(obj, "command");
+                s.url = json::parse::get_string(obj, "url");
+                std::string transport = json::parse::get_string(obj, "transport");
+                if (!transport.empty()) s.transport = transport;
+                else if (!s.url.empty()) s.transport = "http";
+                read_int(obj, "timeout_ms", s.timeout_ms);
                 
                 // Parse enabled (default true)
                 s.enabled = true;
@@ -66,7 +116,8 @@ Config Config::load_default() {
                     s.enabled = false;
                 }
 
-                if (!s.name.empty() && !s.command.empty()) {
+                bool reachable = (s.transport == "http") ? !s.url.empty() : !s.command.empty();
+                if (!s.name.empty() && reachable) {
                     config.servers.push_back(s);
                 }
             }
@@ -86,9 +137,27 @@ void Config::save_default() const {
     file << "{\n";
     file << "  \"default_provider\": " << json::str(default_provider) << ",\n";
     file << "  \"ollama_model\": " << json::str(ollama_model) << ",\n";
+    file << "  \"ollama_preload\": " << (ollama_preload ? "true" : "false") << ",\n";
+    file << "  \"ollama_keep_alive\": " << json::str(ollama_keep_alive) << ",\n";
+    file << "  \"ollama_num_ctx\": " << ollama_num_ctx << ",\n";
+    file << "  \"ollama_num_thread\": " << ollama_num_thread << ",\n";
+    file << "  \"ollama_num_batch\": " << ollama_num_batch << ",\n";
     file << "  \"gemini_api_key\": " << json::str(gemini_api_key) << ",\n";
     file << "  \"gemini_model\": " << json::str(gemini_model) << ",\n";
+    file << "  \"gemini_url\": " << json::str(gemini_url) << ",\n";
     file << "  \"human_in_loop\": " << (human_in_loop ? "true" : "false") << ",\n";
+    file << "  \"http_connect_timeout_ms\": " << http_connect_timeout_ms << ",\n";
+    file << "  \"http_timeout_ms\": " << http_timeout_ms << ",\n";
+    file << "  \"server_workers\": " << server_workers << ",\n";
+    std::vector<std::string> limits_json;
+    for (const auto& l : tool_limits) limits_json.push_back(json::str(l));
+    file << "  \"tool_limits\": " << json::arr(limits_json) << ",\n";
+    file << "  \"server_cache_mb\": " << server_cache_mb << ",\n";
+    file << "  \"server_zygote_workers\": " << server_zygote_workers << ",\n";
+    file << "  \"server_worker_max_jobs\": " << server_worker_max_jobs << ",\n";
+    file << "  \"server_cgroups\": " << (server_cgroups ? "true" : "false") << ",\n";
+    file << "  \"server_cgroup_root\": " << json::str(server_cgroup_root) << ",\n";
+    file << "  \"server_shell_session\": " << (server_shell_session ? "true" : "false") << ",\n";
     
     file << "  \"servers\": [\n";
     for (size_t i = 0; i < servers.size(); ++i) {
@@ -101,6 +170,11 @@ void Config::save_default() const {
             cmd_json.push_back(json::str(arg));
         }
         file << "      \"command\": " << json::arr(cmd_json) << ",\n";
+        if (servers[i].transport != "stdio") {
+            file << "      \"transport\": " << json::str(servers[i].transport) << ",\n";
+            file << "      \"url\": " << json::str(servers[i].url) << ",\n";
+        }
+        file << "      \"timeout_ms\": " << servers[i].timeout_ms << ",\n";
         file << "      \"enabled\": " << (servers[i].enabled ? "true" : "false") << "\n";
         
         file << "    }" << (i < servers.size() - 1 ? "," : "") << "\n";
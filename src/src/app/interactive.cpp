@@ -4,11 +4,14 @@
 #include "utils/json.hpp"
 #include "utils/terminal.hpp"
 #include "utils/logger.hpp"
+#include "utils/cancel.hpp"
+#include "utils/http.hpp"
 #include <iostream>
 #include <algorithm>
 #include <thread>
 #include <chrono>
 #include <set>
+#include <memory>
 #include <termios.h>
 #include <unistd.h>
 
@@ -30,17 +33,14 @@ std::string get_password(const std::string& prompt) {
 
 void run_interactive_session(MCPClient& client) {
     std::string input;
-    std::vector<std::map<std::string, std::string>> conversation_history;
+    Conversation conversation_history;
     
     // Initial System Prompt
-    std::map<std::string, std::string> system_msg;
-    system_msg["role"] = json::str("system");
-    system_msg["content"] = json::str(
+    conversation_history.add("system",
         "You are a powerful terminal assistant with access to system tools, file management, and web search. "
         "You can run shell commands, read/write files, search the web for information, and search academic papers. "
         "Be concise and helpful. When executing commands, show the user what you're doing."
     );
-    conversation_history.push_back(system_msg);
     
     std::cout << "\033[2J\033[H" << std::flush;
     term::print_header("OLLMCPC PREMIUM v3.6", term::CYAN);
@@ -90,6 +90,7 @@ void run_interactive_session(MCPClient& client) {
                       << term::CYAN << "  /toggle  " << term::RESET << "» Enable/Disable specific servers\n"
                       << term::CYAN << "  /config  " << term::RESET << "» Open Preferences Manager\n"
                       << term::CYAN << "  /list    " << term::RESET << "» Inventory of available tools\n"
+                      << term::CYAN << "  /stats   " << term::RESET << "» Server cache and tool statistics\n"
                       << term::CYAN << "  /quit    " << term::RESET << "» Terminate session\n\n";
             continue;
         }
@@ -119,9 +120,13 @@ void run_interactive_session(MCPClient& client) {
                     
                     std::cout << "  " << (s.enabled ? (is_active ? term::GREEN + "▣" : term::YELLOW + "◒") : term::RED + "▢") << term::RESET << " " 
                               << term::BOLD << s.name << term::RESET << " [" << (s.enabled ? (is_active ? "ACTIVE" : "PENDING") : "DISABLED") << "]\n";
-                    std::cout << "    " << term::DIM << "Cmd: ";
-                    for (const auto& c : s.command) std::cout << c << " ";
-                    std::cout << term::RESET << "\n";
+                    if (s.transport == "http") {
+                        std::cout << "    " << term::DIM << "Url: " << s.url << term::RESET << "\n";
+                    } else {
+                        std::cout << "    " << term::DIM << "Cmd: ";
+                        for (const auto& c : s.command) std::cout << c << " ";
+                        std::cout << term::RESET << "\n";
+                    }
                 }
             }
             std::cout << "\n  " << term::DIM << "Tip: Use '/toggle <name>' to enable/disable. Restart required for process changes." << term::RESET << "\n";
@@ -160,6 +165,7 @@ void run_interactive_session(MCPClient& client) {
             else cfg.default_provider = "manual";
             
             client.setProvider(createProvider(cfg));
+            if (cfg.ollama_preload) client.getLLM()->warmUp();   // loads in the background
             std::cout << term::YELLOW << "  🔄 SHIFTED: [" << old << "] ➔ [" << term::BOLD << client.getLLM()->name() << term::RESET << "]\n";
             conversation_history.clear();
             continue;
@@ -182,11 +188,48 @@ void run_interactive_session(MCPClient& client) {
             continue;
         }
 
+        if (input == "/stats") {
+            term::print_header("SERVER STATISTICS", term::MAGENTA);
+            std::vector<std::pair<std::string, std::string>> reports;
+            for (const auto& server : client.getServers()) {
+                std::string stats = server->getStats();
+                if (!stats.empty()) reports.push_back({server->getName(), stats});
+            }
+            // The provider's HTTP connection pool, in the same shape as a server's stats
+            reports.push_back({"llm", "{\"http\":" + HTTPClient::statsJson() + "}"});
+            for (const auto& report : reports) {
+                const std::string& stats = report.second;
+                std::cout << "  " << term::GREEN << "▣" << term::RESET << " " << term::BOLD << report.first << term::RESET << "\n";
+                // Each section is an object of counters, optionally with per-tool sub-objects
+                for (const auto& section : json::parse::members(stats)) {
+                    std::string scalars;
+                    std::vector<std::pair<std::string, std::string>> nested;
+                    for (const auto& field : json::parse::members(section.second)) {
+                        if (!field.second.empty() && field.second[0] == '{') nested.push_back(field);
+                        else scalars += " " + field.first + "=" + json::parse::scalar(field.second);
+                    }
+                    std::cout << "    " << term::CYAN << section.first << term::RESET << scalars << "\n";
+                    for (const auto& group : nested) {
+                        for (const auto& row : json::parse::members(group.second)) {
+                            std::string cols;
+                            for (const auto& c : json::parse::members(row.second)) {
+                                cols += " " + c.first + "=" + json::parse::scalar(c.second);
+                            }
+                            std::cout << "      " << term::DIM << row.first << term::RESET << cols << "\n";
+                        }
+                    }
+                }
+            }
+            std::cout << "\n";
+            continue;
+        }
+
         if (input == "/config") {
             Config::interactive_setup();
             Config cfg = Config::load_default();
             // Immediate update
             client.setProvider(createProvider(cfg));
+            if (cfg.ollama_preload) client.getLLM()->warmUp();   // loads in the background
             client.human_in_loop = cfg.human_in_loop;
             std::cout << term::GREEN << "  ✨ System preferences applied immediately. Mode: " << term::BOLD << client.getLLM()->name() << term::RESET << "\n";
             conversation_history.clear();
@@ -206,32 +249,53 @@ void run_interactive_session(MCPClient& client) {
                 if (!is_manual) term::print_thought("Interpreting tool results & generating summary...");
             }
 
-            std::string response = llm->chat(current_message, conversation_history);
+            // Streaming providers fill the ASSISTANT box as tokens arrive;
+            // Ctrl-C stops the generation and keeps what came so far
+            term::LiveBox reply("ASSISTANT", term::WHITE, true);
+            ChatResponse response;
+            {
+                std::unique_ptr<utils::CancelScope> cancel_scope;
+                if (!is_manual) cancel_scope = std::make_unique<utils::CancelScope>();   // manual mode reads stdin
+                response = llm->chatStream(current_message, conversation_history,
+                    [&](const std::string& text) { reply.write(text); });
+            }
+            bool reply_streamed = reply.opened();
+            reply.close();
             
-            std::string msg_obj = json::parse::get_object(response, "message");
-            if (msg_obj == "{}") msg_obj = response;
-
-            std::string content = json::parse::get_string(msg_obj, "content");
-            if (!content.empty()) {
-                term::draw_box("ASSISTANT", content, term::WHITE);
+            if (!response.error.empty()) {
+                std::cout << term::RED << "  " << llm->name() << ": " << response.error << term::RESET << "\n";
+                utils::Logger::error(llm->name() + ": " + response.error);
+            }
+            if (!response.content.empty()) {
+                if (!reply_streamed) term::draw_box("ASSISTANT", response.content, term::WHITE);
                 
                 // Keep context for conversational flow
-                std::map<std::string, std::string> hist_item;
-                hist_item["role"] = json::str("assistant");
-                hist_item["content"] = json::str(content);
-                conversation_history.push_back(hist_item);
+                conversation_history.add("assistant", response.content);
+            }
+            if (!is_manual && response.total_ms >= 0) {
+                std::cout << "  " << term::DIM;
+                if (response.first_token_ms >= 0) std::cout << "first token " << response.first_token_ms << " ms, ";
+                std::cout << "total " << response.total_ms << " ms";
+                // Ollama's split: loading the model is not inference time
+                if (response.load_ms >= 0 && response.eval_ms >= 0) {
+                    std::cout << " (model load " << (long)response.load_ms << " ms, prompt "
+                              << (long)std::max(response.prompt_eval_ms, 0.0) << " ms, generation "
+                              << (long)response.eval_ms << " ms)";
+                }
+                if (response.prompt_tokens >= 0 && response.completion_tokens >= 0) {
+                    std::cout << ", tokens " << response.prompt_tokens << " in / " << response.completion_tokens << " out";
+                }
+                if (response.eval_ms > 0 && response.completion_tokens > 0) {
+                    std::cout << " (" << (long)(response.completion_tokens * 1000.0 / response.eval_ms) << " tok/s)";
+                }
+                std::cout << term::RESET << "\n";
             }
             
             // Analyze for Tool Calls
-            std::string tool_calls_arr = json::parse::get_array(msg_obj, "tool_calls");
-            if (tool_calls_arr.empty() || tool_calls_arr == "[]") break;
-            
-            std::string call_obj = json::parse::first_object(tool_calls_arr); 
-            if (call_obj == "{}") break;
-
-            std::string tool_name = json::parse::get_string(call_obj, "name");
-            std::string tool_args = json::parse::get_object(call_obj, "arguments");
-            if (tool_name.empty()) break;
+            if (response.tool_calls.empty()) break;
+            const ToolCall& call = response.tool_calls.front();
+            std::string tool_name = call.name;
+            std::string tool_args = call.arguments;
 
             // Security & Loop Prevention
             std::string sig = tool_name + ":" + tool_args;
@@ -241,17 +305,10 @@ void run_interactive_session(MCPClient& client) {
             }
             turn_tool_signatures.insert(sig);
 
-            // COMPACTION: Remove newlines from tool_args to prevent breaking the IPC pipe
-            std::string compacted_args;
-            for (char c : tool_args) {
-                if (c == '\n' || c == '\r' || c == '\t') compacted_args += ' ';
-                else compacted_args += c;
-            }
-            tool_args = compacted_args;
-
             // SUDO DETECTION (specifically for run_shell_command)
             if (tool_name == "run_shell_command") {
-                std::string cmd_val = json::parse::get_string(tool_args, "command");
+                auto command = call.args.find("command");
+                std::string cmd_val = command == call.args.end() ? "" : json::parse::scalar(command->second);
                 if (cmd_val.find("sudo ") == 0) {
                     term::draw_box("SUDO PRIVILEGE ESCALATION", "The assistant requested root permissions for:\n" + term::DIM + cmd_val + term::RESET, term::MAGENTA);
                     std::string pass = get_password("  [sudo] password for user: ");
@@ -300,11 +357,17 @@ void run_interactive_session(MCPClient& client) {
 
             // Execution phase
             std::string raw_result = "";
+            std::string resources;
             bool success = false;
             utils::Logger::debug("Trying " + std::to_string(client.getServers().size()) + " servers for tool: " + tool_name);
+            utils::CancelScope cancel_scope; // Ctrl-C now cancels the call instead of the session
+            // Streaming tools fill the output box while they run
+            term::LiveBox live(is_manual ? "LOCAL DEVICE DATA: " + tool_name : "SYSTEM OUTPUT LOG", term::GREEN);
             for (const auto& server : client.getServers()) {
                  utils::Logger::debug("Trying server: " + server->getName());
+                 server->setProgressHandler([&live](const std::string& text) { live.write(text); });
                  std::string r = server->callTool(tool_name, tool_args, exec_dangerous);
+                 server->setProgressHandler(nullptr);
                  utils::Logger::debug("Server " + server->getName() + " returned: " + (r.length() > 100 ? r.substr(0, 100) : r));
                  // Skip if empty or if server doesn't know this tool
                  if (!r.empty() && 
@@ -312,29 +375,43 @@ void run_interactive_session(MCPClient& client) {
                      r.find("not found") == std::string::npos &&
                      r.find("MCP error") == std::string::npos) {
                      raw_result = r;
+                     resources = server->getLastResources();
                      success = true;
                      break;
                  }
+                 if (utils::CancelScope::requested()) break;
             }
             
             if (!success) {
                 raw_result = "Error: Tool not found on any connected server or script failed!";
             }
+            bool streamed = live.opened();
+            if (streamed) {
+                // A limited run ends with a note that was not part of the stream
+                size_t last = raw_result.rfind('\n');
+                std::string note = last == std::string::npos ? "" : raw_result.substr(last + 1);
+                if (note.compare(0, 7, "[Error:") == 0) live.write("\n" + note);
+                live.close();
+            }
             
             if (!is_manual) {
                 // PREMIUM: Change System Log color to GREEN for better contrast
-                term::draw_box("SYSTEM OUTPUT LOG", raw_result, term::GREEN);
+                if (!streamed) term::draw_box("SYSTEM OUTPUT LOG", raw_result, term::GREEN);
+                if (!resources.empty()) {
+                    auto field = [&](const char* key) { return json::parse::get_raw_value(resources, std::string("\"") + key + "\":"); };
+                    std::cout << "  " << term::DIM << "cost: cpu " << field("cpu_ms") << " ms (user " << field("user_ms")
+                              << ", sys " << field("system_ms") << "), peak memory " << field("memory_peak_kb")
+                              << " KB, io " << field("io_read_kb") << " KB read / " << field("io_write_kb")
+                              << " KB written" << term::RESET << "\n";
+                }
                 
                 // Force synthesis by adding strong prompt to history
-                std::map<std::string, std::string> tool_context;
-                tool_context["role"] = json::str("user");
-                tool_context["content"] = json::str("Action: Tool [" + tool_name + "] executed.\nResult: " + raw_result + "\nConstraint: Please summarize this data clearly for the human user. Do not call any more tools until the user speaks again.");
-                conversation_history.push_back(tool_context);
+                conversation_history.add("user", "Action: Tool [" + tool_name + "] executed.\nResult: " + raw_result + "\nConstraint: Please summarize this data clearly for the human user. Do not call any more tools until the user speaks again.");
                 
                 // Prepare for next turn in loop
                 current_message = ""; // LLM will rely on conversational context (history)
             } else {
-                term::draw_box("LOCAL DEVICE DATA: " + tool_name, raw_result, term::GREEN);
+                if (!streamed) term::draw_box("LOCAL DEVICE DATA: " + tool_name, raw_result, term::GREEN);
                 break; // Manual is single-turn
             }
             
@@ -0,0 +1,52 @@
+#include "llm/conversation.hpp"
+#include "utils/json.hpp"
+
+void ChatResponse::addToolCall(const std::string& name, const std::string& arguments) {
+    ToolCall call;
+    call.name = name;
+    // Some models send the arguments as a JSON string instead of an object
+    std::string raw = (!arguments.empty() && arguments[0] == '"') ? json::parse::scalar(arguments) : arguments;
+    // One line, so it can go through line-based pipes to the tool servers
+    for (char c : raw) call.arguments += (c == '\n' || c == '\r' || c == '\t') ? ' ' : c;
+    if (call.arguments.find_first_not_of(' ') == std::string::npos) call.arguments = "{}";
+    for (const auto& member : json::parse::members(call.arguments)) call.args[member.first] = member.second;
+    tool_calls.push_back(call);
+}
+
+void Conversation::add(const std::string& role, const std::string& content) {
+    items.push_back({role, content});
+    if (role == "system") system_prompt = content;
+}
+
+void Conversation::clear() {
+    items.clear();
+    system_prompt.clear();
+    for (auto& buffer : buffers) {
+        buffer.json.clear();
+        buffer.count = 0;
+    }
+}
+
+const std::string& Conversation::serialized(Format format) const {
+    Buffer& buffer = buffers[format];
+    for (; buffer.count < items.size(); buffer.count++) {
+        std::string item;
+        if (!append(format, items[buffer.count], item)) continue;
+        if (!buffer.json.empty()) buffer.json += ',';
+        buffer.json += item;
+    }
+    return buffer.json;
+}
+
+// One message as a JSON item; false if the format leaves it out. The key
+// order is json::obj()'s, so requests match what the providers built before
+bool Conversation::append(Format format, const ChatMessage& message, std::string& out) {
+    if (format == OLLAMA) {
+        out = "{\"content\":" + json::str(message.content) + ",\"role\":" + json::str(message.role) + "}";
+        return true;
+    }
+    if (message.role == "system") return false;   // goes to system_instruction
+    std::string role = (message.role == "assistant" || message.role == "model") ? "model" : "user";
+    out = "{\"parts\":[{\"text\":" + json::str(message.content) + "}],\"role\":" + json::str(role) + "}";
+    return true;
+}
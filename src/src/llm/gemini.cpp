@@ -2,10 +2,66 @@
 #include "utils/json.hpp"
 #include "utils/http.hpp"
 #include "utils/logger.hpp"
+#include "utils/cancel.hpp"
 #include <map>
+#include <chrono>
+#include <cstdlib>
 
-GeminiProvider::GeminiProvider(const std::string& model, const std::string& key) 
-    : model_name(model), api_key(key) {}
+GeminiProvider::GeminiProvider(const std::string& model, const std::string& key, const std::string& url) 
+    : api_key(key), model_name(model), api_url(url) {}
+
+// One GenerateContentResponse, whole or a stream event: the text parts of
+// the first candidate, every functionCall part and the usage counters. The
+// text is appended piece by piece and also handed to on_token.
+static void read_candidate(const std::string& reply, ChatResponse& response,
+                           const LLMProvider::TokenHandler& on_token = nullptr) {
+    for (const auto& member : json::parse::members(reply)) {
+        if (member.first == "candidates") {
+            std::string content = json::parse::get_object(json::parse::first_object(member.second), "content");
+            for (const auto& part : json::parse::items(json::parse::get_array(content, "parts"))) {
+                for (const auto& field : json::parse::members(part)) {
+                    if (field.first == "text") {
+                        std::string piece = json::parse::scalar(field.second);
+                        if (piece.empty()) continue;
+                        response.content += piece;
+                        if (on_token) on_token(piece);
+                    } else if (field.first == "functionCall") {
+                        std::string name, args;
+                        for (const auto& call : json::parse::members(field.second)) {
+                            if (call.first == "name") name = json::parse::scalar(call.second);
+                            else if (call.first == "args") args = call.second;
+                        }
+                        if (!name.empty()) response.addToolCall(name, args);
+                    }
+                }
+            }
+        } else if (member.first == "usageMetadata") {
+            for (const auto& count : json::parse::members(member.second)) {
+                if (count.first == "promptTokenCount") response.prompt_tokens = std::atol(count.second.c_str());
+                else if (count.first == "candidatesTokenCount") response.completion_tokens = std::atol(count.second.c_str());
+            }
+        }
+    }
+}
+
+// {"error":{"code":..,"message":..,"status":..}} -> its message
+static std::string read_error(const std::string& body) {
+    if (body.empty()) return "no reply from Gemini";
+    std::string message = json::parse::get_string(json::parse::get_object(body, "error"), "message");
+    return message.empty() ? "unexpected reply from Gemini: " + body : message;
+}
+
+// A generateContent reply; a body without candidates is an error
+static ChatResponse from_response(const std::string& body) {
+    ChatResponse response;
+    std::string candidates = json::parse::get_array(body, "candidates");
+    if (candidates.empty() || candidates == "[]") {
+        response.error = read_error(body);
+        return response;
+    }
+    read_candidate(body, response);
+    return response;
+}
 
 void GeminiProvider::addTool(const std::string& name, const std::string& description, 
                              const std::string& parameters) {
@@ -18,116 +74,154 @@ void GeminiProvider::addTool(const std::string& name, const std::string& descrip
     
     tools_json.push_back(json::obj(tool));
     tools.push_back({name, description, parameters});
+    tools_block_valid = false;
     utils::Logger::debug("GeminiProvider: Added tool " + name + " (Total: " + std::to_string(tools.size()) + ")");
 }
 
-std::string GeminiProvider::chat(const std::string& user_message, 
-                                 const std::vector<std::map<std::string, std::string>>& history) {
-    std::vector<std::string> contents;
-    std::string system_instr;
-    
-    for (const auto& msg : history) {
-        std::string role = "user";
-        auto it_role = msg.find("role");
-        if (it_role != msg.end()) {
-            std::string r_val = it_role->second;
-            // Remove quotes if present
-            if (r_val.front() == '"') r_val = r_val.substr(1, r_val.length() - 2);
-            
-            if (r_val == "assistant" || r_val == "model") role = "model";
-            else if (r_val == "system") {
-                auto it_content = msg.find("content");
-                if (it_content != msg.end()) {
-                    std::string s_val = it_content->second;
-                    if (s_val.front() == '"') s_val = s_val.substr(1, s_val.length() - 2);
-                    system_instr = s_val;
-                }
-                continue;
-            }
+std::string GeminiProvider::build_request(const std::string& user_message,
+                                          const Conversation& history) {
+    const std::string& system_instr = history.systemPrompt();
+
+    // json::obj() of {contents, system_instruction, tools}, keys in that
+    // order, with the two fixed blocks kept serialized between calls
+    if (system_instr != system_text) {
+        system_text = system_instr;
+        system_block.clear();
+        if (!system_instr.empty()) {
+            std::map<std::string, std::string> s_part;
+            s_part["text"] = json::str(system_instr);
+            system_block = ",\"system_instruction\":" + json::obj({{"parts", json::arr({json::obj(s_part)})}});
         }
-        
-        std::map<std::string, std::string> part;
-        auto it_content = msg.find("content");
-        if (it_content != msg.end()) {
-            part["text"] = it_content->second;
+    }
+
+    if (!tools_block_valid) {
+        tools_block = "}";
+        if (!tools_json.empty()) {
+            std::map<std::string, std::string> tool_container;
+            tool_container["function_declarations"] = json::arr(tools_json);
+            tools_block = ",\"tools\":" + json::arr({json::obj(tool_container)}) + "}";
         }
-        
-        std::map<std::string, std::string> content;
-        content["role"] = json::str(role);
-        content["parts"] = json::arr({json::obj(part)});
-        contents.push_back(json::obj(content));
+        tools_block_valid = true;
     }
-    
+
+    // Past turns come serialized from history; only this message is new
+    const std::string& past = history.serialized(Conversation::GEMINI);
+    std::string request;
+    request.reserve(past.size() + user_message.size() + system_block.size() + tools_block.size() + 64);
+    request += "{\"contents\":[";
+    request += past;
     if (!user_message.empty()) {
-        std::map<std::string, std::string> current_part;
-        current_part["text"] = json::str(user_message);
-        
-        std::map<std::string, std::string> current_content;
-        current_content["role"] = json::str("user");
-        current_content["parts"] = json::arr({json::obj(current_part)});
-        contents.push_back(json::obj(current_content));
+        if (!past.empty()) request += ",";
+        request += "{\"parts\":[{\"text\":" + json::str(user_message) + "}],\"role\":\"user\"}";
     }
+    request += "]";
+    request += system_block;
+    request += tools_block;
+    return request;
+}
 
-    std::map<std::string, std::string> root;
-    root["contents"] = json::arr(contents);
+ChatResponse GeminiProvider::chat(const std::string& user_message, 
+                                  const Conversation& history) {
+    std::string request_json = build_request(user_message, history);
+    std::string url = api_url + "/models/" + model_name + ":generateContent?key=" + api_key;
     
-    if (!system_instr.empty()) {
-        std::map<std::string, std::string> s_part;
-        s_part["text"] = json::str(system_instr);
-        root["system_instruction"] = json::obj({{"parts", json::arr({json::obj(s_part)})}});
-    }
+    utils::Logger::debug("Gemini Request: " + request_json);
+    auto started = std::chrono::steady_clock::now();
+    std::string body = HTTPClient::post(url, request_json);
+    long total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    utils::Logger::debug("Gemini Response: " + body);
+
+    ChatResponse response = from_response(body);
+    response.total_ms = total_ms;
+    return response;
+}
+
+std::vector<ChatResponse> GeminiProvider::chatBatch(const std::vector<std::string>& user_messages,
+                                                    const Conversation& history) {
+    std::vector<std::string> requests;
+    for (const auto& message : user_messages) requests.push_back(build_request(message, history));
+    std::string url = api_url + "/models/" + model_name + ":generateContent?key=" + api_key;
+    utils::Logger::debug("Gemini Batch: " + std::to_string(requests.size()) + " requests");
 
-    if (!tools_json.empty()) {
-        std::map<std::string, std::string> tool_container;
-        tool_container["function_declarations"] = json::arr(tools_json);
-        root["tools"] = json::arr({json::obj(tool_container)});
+    std::vector<ChatResponse> replies;
+    for (const auto& reply : HTTPClient::postAll(url, requests)) {
+        utils::Logger::debug("Gemini Response: " + reply.body);
+        ChatResponse response = from_response(reply.body);
+        if (!reply.ok()) response.error = reply.error;
+        response.total_ms = reply.total_ms;
+        replies.push_back(response);
     }
+    return replies;
+}
 
-    std::string request_json = json::obj(root);
-    std::string url = "https://generativelanguage.googleapis.com/v1beta/models/" + model_name + ":generateContent?key=" + api_key;
-    
+// Server-sent events, one GenerateContentResponse per event:
+//   data: {"candidates":[{"content":{"parts":[{"text":"<piece>"}],"role":"model"}}]}
+// A functionCall arrives as a whole part of its own. Errors come back as a
+// plain JSON body instead of events; their message becomes the error.
+ChatResponse GeminiProvider::chatStream(const std::string& user_message,
+                                        const Conversation& history,
+                                        const TokenHandler& on_token) {
+    std::string request_json = build_request(user_message, history);
+    std::string url = api_url + "/models/" + model_name + ":streamGenerateContent?alt=sse&key=" + api_key;
     utils::Logger::debug("Gemini Request: " + request_json);
-    std::string response = HTTPClient::post(url, request_json);
-    utils::Logger::debug("Gemini Response: " + response);
 
-    // Basic normalization for interactive.cpp
-    std::string candidates = json::parse::get_array(response, "candidates");
-    if (candidates.empty() || candidates == "[]") {
-        return response; // Return error or empty
-    }
+    ChatResponse response;
+    std::string pending;                  // partial line
+    std::string data;                     // data: lines of the current event
+    std::string raw;                      // anything that is not SSE
+    size_t events = 0;
+    auto started = std::chrono::steady_clock::now();
+    auto elapsed_ms = [&]() {
+        return (long)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count();
+    };
 
-    std::string first_candidate = json::parse::first_object(candidates);
-    std::string content_obj = json::parse::get_object(first_candidate, "content");
-    std::string parts_arr = json::parse::get_array(content_obj, "parts");
-    std::string first_part = json::parse::first_object(parts_arr);
-    
-    std::string text = json::parse::get_string(first_part, "text");
-    std::string func_call = json::parse::get_object(first_part, "functionCall");
-    
-    std::map<std::string, std::string> msg;
-    msg["role"] = json::str("assistant");
-    msg["content"] = json::str(text);
-    
-    if (func_call != "{}" && !func_call.empty()) {
-        std::string name = json::parse::get_string(func_call, "name");
-        std::string args = json::parse::get_object(func_call, "args");
-        
-        // Compact arguments
-        std::string compact_args;
-        for (char c : args) {
-            if (c == '\n' || c == '\r' || c == '\t') compact_args += ' ';
-            else compact_args += c;
+    auto handle_event = [&](const std::string& event) {
+        events++;
+        read_candidate(event, response, [&](const std::string& piece) {
+            if (response.first_token_ms < 0) response.first_token_ms = elapsed_ms();
+            if (on_token) on_token(piece);
+        });
+    };
+    auto handle_line = [&](std::string line) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) {
+            // A blank line ends the event
+            if (!data.empty()) handle_event(data);
+            data.clear();
+        } else if (line.compare(0, 5, "data:") == 0) {
+            size_t start = (line.size() > 5 && line[5] == ' ') ? 6 : 5;
+            if (!data.empty()) data += '\n';
+            data += line.substr(start);
+        } else if (line[0] != ':' && line.compare(0, 6, "event:") != 0 &&
+                   line.compare(0, 3, "id:") != 0 && line.compare(0, 6, "retry:") != 0) {
+            raw += line + "\n";
         }
-        
-        std::map<std::string, std::string> tool_call;
-        tool_call["name"] = json::str(name);
-        tool_call["arguments"] = compact_args;
-        
-        msg["tool_calls"] = json::arr({json::obj(tool_call)});
+    };
+
+    bool ok = HTTPClient::postStream(url, request_json, [&](const char* chunk, size_t len) {
+        pending.append(chunk, len);
+        size_t start = 0, nl;
+        while ((nl = pending.find('\n', start)) != std::string::npos) {
+            handle_line(pending.substr(start, nl - start));
+            start = nl + 1;
+        }
+        pending.erase(0, start);
+        // Ctrl-C stops the generation; what arrived so far is kept
+        return !utils::CancelScope::requested();
+    });
+    if (!pending.empty()) handle_line(pending);
+    if (!data.empty()) handle_event(data);
+    response.total_ms = elapsed_ms();
+
+    if (events == 0) {
+        utils::Logger::debug("Gemini Response: " + raw);
+        response.error = ok ? read_error(raw) : "no reply from Gemini";
+        return response;
     }
-    
-    std::map<std::string, std::string> final_root;
-    final_root["message"] = json::obj(msg);
-    
-    return json::obj(final_root);
+    utils::Logger::debug("Gemini Response (" + std::to_string(events) + " events): " +
+                         std::to_string(response.content.size()) + " bytes, " +
+                         std::to_string(response.tool_calls.size()) + " tool calls");
+    return response;
 }
@@ -9,14 +9,12 @@ void ManualProvider::addTool(const std::string& name, const std::string& descrip
     tools.push_back({name, description, parameters});
 }
 
-std::string ManualProvider::chat(const std::string& user_message, 
-                                 const std::vector<std::map<std::string, std::string>>& history) {
+ChatResponse ManualProvider::chat(const std::string& user_message, 
+                                  const Conversation& history) {
+    ChatResponse response;
     if (tools.empty()) {
-        std::map<std::string, std::string> msg;
-        msg["content"] = json::str("No tools available.");
-        std::map<std::string, std::string> root;
-        root["message"] = json::obj(msg);
-        return json::obj(root);
+        response.content = "No tools available.";
+        return response;
     }
     int choice = 0;
     try { choice = std::stoi(user_message); } catch (...) {}
@@ -37,7 +35,7 @@ std::string ManualProvider::chat(const std::string& user_message,
         term::display_tool_menu(tool_infos);
         
         if (user_message == "list") {
-            return "{\"message\": {\"content\": \"\"}}";
+            return response;
         }
 
         std::cout << "  " << term::YELLOW << "0. Skip" << term::RESET << " | or type name directly\n";
@@ -47,11 +45,8 @@ std::string ManualProvider::chat(const std::string& user_message,
         std::string choice_str;
         std::getline(std::cin, choice_str);
         if (choice_str.empty()) {
-            std::map<std::string, std::string> msg;
-            msg["content"] = json::str("Manual selection skipped.");
-            std::map<std::string, std::string> root;
-            root["message"] = json::obj(msg);
-            return json::obj(root);
+            response.content = "Manual selection skipped.";
+            return response;
         }
         try { choice = std::stoi(choice_str); } catch (...) {
             for (size_t i = 0; i < tools.size(); i++) {
@@ -112,23 +107,10 @@ std::string ManualProvider::chat(const std::string& user_message,
             }
         }
 
-        std::map<std::string, std::string> call;
-        call["name"] = json::str(t.name);
-        call["id"] = json::str("manual_call_" + std::to_string(choice));
-        call["arguments"] = args;
-
-        std::map<std::string, std::string> msg;
-        msg["tool_calls"] = json::arr({json::obj(call)});
-        
-        std::map<std::string, std::string> root;
-        root["message"] = json::obj(msg);
-        
-        return json::obj(root);
+        response.addToolCall(t.name, args);
+        return response;
     }
 
-    std::map<std::string, std::string> msg;
-    msg["content"] = json::str("Manual selection skipped.");
-    std::map<std::string, std::string> root;
-    root["message"] = json::obj(msg);
-    return json::obj(root);
+    response.content = "Manual selection skipped.";
+    return response;
 }
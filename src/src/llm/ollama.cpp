@@ -2,11 +2,30 @@
 #include "utils/json.hpp"
 #include "utils/http.hpp"
 #include "utils/logger.hpp"
+#include "utils/cancel.hpp"
 #include <fstream>
 #include <map>
+#include <chrono>
+#include <cstdlib>
 
-OllamaProvider::OllamaProvider(const std::string& model) 
-    : model_name(model), ollama_url("http://localhost:11434") {}
+// keep_alive is a duration ("30m") or a number of seconds (-1 = forever)
+static std::string keep_alive_json(const std::string& value) {
+    bool number = !value.empty() && value.find_first_not_of("-0123456789") == std::string::npos;
+    return number ? value : json::str(value);
+}
+
+OllamaProvider::OllamaProvider(const std::string& model, const OllamaOptions& opts) 
+    : model_name(model), ollama_url("http://localhost:11434"), options(opts) {
+    request_head = "{";
+    if (!options.keep_alive.empty()) request_head += "\"keep_alive\":" + keep_alive_json(options.keep_alive) + ",";
+    request_head += "\"messages\":[";
+
+    std::map<std::string, std::string> values;
+    if (options.num_batch > 0) values["num_batch"] = std::to_string(options.num_batch);
+    if (options.num_ctx > 0) values["num_ctx"] = std::to_string(options.num_ctx);
+    if (options.num_thread > 0) values["num_thread"] = std::to_string(options.num_thread);
+    if (!values.empty()) options_json = json::obj(values);
+}
 
 void OllamaProvider::addTool(const std::string& name, const std::string& description, 
                              const std::string& parameters) {
@@ -23,36 +42,220 @@ void OllamaProvider::addTool(const std::string& name, const std::string& descrip
     
     tools_json.push_back(json::obj(tool));
     tools.push_back({name, description, parameters});
+    request_tail_valid = false;
 }
 
-std::string OllamaProvider::chat(const std::string& user_message, 
-                                 const std::vector<std::map<std::string, std::string>>& history) {
-    std::vector<std::string> messages;
-    
-    for (const auto& msg : history) {
-        messages.push_back(json::obj(msg));
+std::string OllamaProvider::build_request(const std::string& user_message,
+                                          const Conversation& history,
+                                          bool stream) {
+    // Same bytes as json::obj() of {keep_alive, messages, model, options,
+    // stream, tools}, whose keys it emits in that order; past messages come
+    // serialized from history
+    if (!request_tail_valid) {
+        std::string model_block = "],\"model\":" + json::str(model_name);
+        if (!options_json.empty()) model_block += ",\"options\":" + options_json;
+        std::string tools_block = ",\"tools\":" + json::arr(tools_json) + "}";
+        for (int s = 0; s < 2; s++) {
+            request_tail[s] = model_block + ",\"stream\":" + (s ? "true" : "false") + tools_block;
+        }
+        request_tail_valid = true;
     }
+
+    const std::string& messages = history.serialized(Conversation::OLLAMA);
+    const std::string& tail = request_tail[stream ? 1 : 0];
+    std::string request;
+    request.reserve(request_head.size() + messages.size() + user_message.size() + tail.size() + 64);
+    request += request_head;
+    request += messages;
     
     if (!user_message.empty()) {
-        std::map<std::string, std::string> user_msg;
-        user_msg["role"] = json::str("user");
-        user_msg["content"] = json::str(user_message);
-        messages.push_back(json::obj(user_msg));
+        if (!messages.empty()) request += ",";
+        request += "{\"content\":" + json::str(user_message) + ",\"role\":\"user\"}";
     }
     
+    request += tail;
+    return request;
+}
+
+// {"function":{"name":..,"arguments":{..}}}, or the name and arguments bare
+static void read_tool_call(const std::string& call_json, ChatResponse& response) {
+    std::string call = call_json;
+    for (const auto& member : json::parse::members(call_json)) {
+        if (member.first == "function") call = member.second;
+    }
+    std::string name, arguments;
+    for (const auto& field : json::parse::members(call)) {
+        if (field.first == "name") name = json::parse::scalar(field.second);
+        else if (field.first == "arguments") arguments = field.second;
+    }
+    if (!name.empty()) response.addToolCall(name, arguments);
+}
+
+// Token counts and timings from the final reply; durations are in ns
+static void read_counter(const std::string& key, const std::string& value, ChatResponse& response) {
+    if (key == "prompt_eval_count") response.prompt_tokens = std::atol(value.c_str());
+    else if (key == "eval_count") response.completion_tokens = std::atol(value.c_str());
+    else if (key == "load_duration") response.load_ms = std::atof(value.c_str()) / 1e6;
+    else if (key == "prompt_eval_duration") response.prompt_eval_ms = std::atof(value.c_str()) / 1e6;
+    else if (key == "eval_duration") response.eval_ms = std::atof(value.c_str()) / 1e6;
+}
+
+// A whole /api/chat reply: {"message":{...},"done":true,<counters>} or {"error":..}
+static ChatResponse parse_reply(const std::string& body) {
+    ChatResponse response;
+    bool has_message = false;
+    for (const auto& member : json::parse::members(body)) {
+        if (member.first == "message") {
+            has_message = true;
+            for (const auto& field : json::parse::members(member.second)) {
+                if (field.first == "content") response.content = json::parse::scalar(field.second);
+                else if (field.first == "tool_calls") {
+                    for (const auto& call : json::parse::items(field.second)) read_tool_call(call, response);
+                }
+            }
+        } else if (member.first == "error") {
+            response.error = json::parse::scalar(member.second);
+        } else {
+            read_counter(member.first, member.second, response);
+        }
+    }
+    if (!has_message && response.error.empty()) {
+        response.error = body.empty() ? "no reply from Ollama" : "unexpected reply from Ollama: " + body;
+    }
+    return response;
+}
+
+// Ollama answers an empty message list by loading the model and replying
+// {"message":{"content":""},"done_reason":"load","done":true}. The request
+// carries no tools, so it only reads fields fixed at construction and can
+// run alongside addTool() on the session thread.
+std::future<ChatResponse> OllamaProvider::warmUp() {
     std::map<std::string, std::string> request;
     request["model"] = json::str(model_name);
-    request["messages"] = json::arr(messages);
-    request["tools"] = json::arr(tools_json);
+    request["messages"] = "[]";
     request["stream"] = "false";
-    
+    if (!options.keep_alive.empty()) request["keep_alive"] = keep_alive_json(options.keep_alive);
+    if (!options_json.empty()) request["options"] = options_json;
     std::string request_json = json::obj(request);
+    utils::Logger::debug("Ollama Warm-up: " + request_json);
+
+    auto promise = std::make_shared<std::promise<ChatResponse>>();
+    std::future<ChatResponse> result = promise->get_future();
+    HTTPClient::postAsync(ollama_url + "/api/chat", request_json, [promise](const HTTPClient::Response& reply) {
+        ChatResponse response = parse_reply(reply.body);
+        if (!reply.ok()) response.error = reply.error;
+        response.total_ms = reply.total_ms;
+        // The load reply has no load_duration; the whole request is the load
+        if (response.load_ms < 0) response.load_ms = reply.total_ms;
+        promise->set_value(response);
+    });
+    return result;
+}
+
+ChatResponse OllamaProvider::chat(const std::string& user_message, 
+                                  const Conversation& history) {
+    std::string request_json = build_request(user_message, history, false);
     
     utils::Logger::debug("Ollama Request: " + request_json);
     
-    std::string response = HTTPClient::post(ollama_url + "/api/chat", request_json);
+    auto started = std::chrono::steady_clock::now();
+    std::string body = HTTPClient::post(ollama_url + "/api/chat", request_json);
+    long total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
     
-    utils::Logger::debug("Ollama Response: " + response);
+    utils::Logger::debug("Ollama Response: " + body);
     
+    ChatResponse response = parse_reply(body);
+    response.total_ms = total_ms;
+    return response;
+}
+
+std::vector<ChatResponse> OllamaProvider::chatBatch(const std::vector<std::string>& user_messages,
+                                                    const Conversation& history) {
+    std::vector<std::string> requests;
+    for (const auto& message : user_messages) requests.push_back(build_request(message, history, false));
+    utils::Logger::debug("Ollama Batch: " + std::to_string(requests.size()) + " requests");
+
+    std::vector<ChatResponse> replies;
+    for (const auto& reply : HTTPClient::postAll(ollama_url + "/api/chat", requests)) {
+        utils::Logger::debug("Ollama Response: " + reply.body);
+        ChatResponse response = parse_reply(reply.body);
+        if (!reply.ok()) response.error = reply.error;
+        response.total_ms = reply.total_ms;
+        replies.push_back(response);
+    }
+    return replies;
+}
+
+// Each line of the stream is one JSON object:
+//   {"message":{"role":"assistant","content":"<piece>"},"done":false}
+// tool_calls come in a message of their own, and the last line has
+// "done":true plus the timing counters.
+ChatResponse OllamaProvider::chatStream(const std::string& user_message,
+                                        const Conversation& history,
+                                        const TokenHandler& on_token) {
+    std::string request_json = build_request(user_message, history, true);
+    utils::Logger::debug("Ollama Request: " + request_json);
+
+    ChatResponse response;
+    std::string pending;                  // partial line
+    std::string error_line;
+    bool done = false;
+    auto started = std::chrono::steady_clock::now();
+    auto elapsed_ms = [&]() {
+        return (long)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count();
+    };
+
+    auto handle_line = [&](const std::string& line) {
+        bool has_message = false;
+        for (const auto& member : json::parse::members(line)) {
+            if (member.first == "message") {
+                has_message = true;
+                for (const auto& field : json::parse::members(member.second)) {
+                    if (field.first == "content") {
+                        std::string piece = json::parse::scalar(field.second);
+                        if (piece.empty()) continue;
+                        if (response.first_token_ms < 0) response.first_token_ms = elapsed_ms();
+                        response.content += piece;
+                        if (on_token) on_token(piece);
+                    } else if (field.first == "tool_calls") {
+                        for (const auto& call : json::parse::items(field.second)) read_tool_call(call, response);
+                    }
+                }
+            } else if (member.first == "done") {
+                done = done || member.second == "true";
+            } else {
+                read_counter(member.first, member.second, response);
+            }
+        }
+        if (!has_message && !done) error_line = line;
+    };
+
+    bool ok = HTTPClient::postStream(ollama_url + "/api/chat", request_json,
+        [&](const char* data, size_t len) {
+            pending.append(data, len);
+            size_t start = 0, nl;
+            while ((nl = pending.find('\n', start)) != std::string::npos) {
+                if (nl > start) handle_line(pending.substr(start, nl - start));
+                start = nl + 1;
+            }
+            pending.erase(0, start);
+            // Ctrl-C stops the generation; what arrived so far is kept
+            return !utils::CancelScope::requested();
+        });
+    if (!pending.empty()) handle_line(pending);
+    response.total_ms = elapsed_ms();
+
+    if (!done && response.content.empty() && response.tool_calls.empty()) {
+        // Nothing generated: pass on Ollama's error ({"error":...}) or the failure
+        utils::Logger::debug("Ollama Response: " + error_line);
+        if (!error_line.empty()) response.error = parse_reply(error_line).error;
+        else response.error = ok ? "empty reply from Ollama" : "no reply from Ollama";
+        return response;
+    }
+
+    utils::Logger::debug("Ollama Response: " + std::to_string(response.content.size()) + " bytes, " +
+                         std::to_string(response.tool_calls.size()) + " tool calls");
     return response;
 }
@@ -0,0 +1,143 @@
+#include "mcp/arg_binder.hpp"
+#include "utils/json.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+ArgBinder::ArgBinder(const std::string& tool_name, const std::vector<ToolArg>& args,
+                     const std::string& input_schema)
+    : tool_name(tool_name) {
+    std::unordered_map<std::string, std::string> property_types;
+    std::vector<std::string> schema_required;
+    for (const auto& member : json::parse::members(input_schema)) {
+        if (member.first == "properties") {
+            for (const auto& prop : json::parse::members(member.second)) {
+                for (const auto& field : json::parse::members(prop.second)) {
+                    if (field.first == "type") property_types[prop.first] = json::parse::scalar(field.second);
+                }
+            }
+        } else if (member.first == "required") {
+            for (const auto& item : json::parse::items(member.second)) {
+                schema_required.push_back(json::parse::scalar(item));
+            }
+        }
+    }
+
+    for (const auto& arg : args) {
+        Slot slot;
+        slot.spec = arg;
+        auto type = property_types.find(arg.key);
+        if (arg.is_switch) slot.type = Type::Boolean;
+        else if (type != property_types.end()) slot.type = type_of(type->second);
+        slot.required = arg.required ||
+                        std::find(schema_required.begin(), schema_required.end(), arg.key) != schema_required.end();
+
+        size_t index = slots.size();
+        names.emplace(arg.key, std::make_pair(index, (size_t)0));
+        for (size_t i = 0; i < arg.aliases.size(); i++) {
+            names.emplace(arg.aliases[i], std::make_pair(index, i + 1));
+        }
+        slots.push_back(slot);
+    }
+}
+
+ArgBinder::Type ArgBinder::type_of(const std::string& schema_type) {
+    if (schema_type == "string") return Type::String;
+    if (schema_type == "integer") return Type::Integer;
+    if (schema_type == "number") return Type::Number;
+    if (schema_type == "boolean") return Type::Boolean;
+    return Type::Any;
+}
+
+const char* ArgBinder::type_name(Type type) {
+    switch (type) {
+        case Type::String: return "a string";
+        case Type::Integer: return "an integer";
+        case Type::Number: return "a number";
+        case Type::Boolean: return "a boolean";
+        default: return "a scalar";
+    }
+}
+
+bool ArgBinder::convert(const Slot& slot, const std::string& raw, std::string& value, std::string& error) const {
+    auto fail = [&]() {
+        error = "Error: " + tool_name + ": argument '" + slot.spec.key + "' must be " +
+                type_name(slot.type) + ", got " + raw;
+        return false;
+    };
+    if (raw[0] == '{' || raw[0] == '[') return fail();
+
+    std::string text = json::parse::scalar(raw);
+    switch (slot.type) {
+        case Type::Integer: {
+            // 42, "42" and 42.0 are the same integer
+            errno = 0;
+            char* end = nullptr;
+            long long n = std::strtoll(text.c_str(), &end, 10);
+            if (!text.empty() && *end == '\0' && errno == 0) {
+                value = std::to_string(n);
+                return true;
+            }
+            double d = std::strtod(text.c_str(), &end);
+            if (text.empty() || *end != '\0' || !std::isfinite(d) || d != std::floor(d) ||
+                std::fabs(d) > 9.0e15) {
+                return fail();
+            }
+            value = std::to_string((long long)d);
+            return true;
+        }
+        case Type::Number: {
+            char* end = nullptr;
+            double d = std::strtod(text.c_str(), &end);
+            if (text.empty() || *end != '\0' || !std::isfinite(d)) return fail();
+            value = text;
+            return true;
+        }
+        case Type::Boolean:
+            if (text == "true" || text == "1") value = "true";
+            else if (text == "false" || text == "0") value = "false";
+            else return fail();
+            return true;
+        default:
+            value = text;
+            return true;
+    }
+}
+
+bool ArgBinder::bind(const std::string& args_json, std::vector<std::string>& argv, std::string& error) const {
+    // Best value per slot: the key beats its aliases, aliases go in order
+    std::vector<std::pair<size_t, std::string>> found(slots.size(), {SIZE_MAX, ""});
+    for (const auto& member : json::parse::members(args_json)) {
+        auto it = names.find(member.first);
+        if (it == names.end()) continue;
+        const std::string& raw = member.second;
+        if (raw.empty() || raw == "null" || raw == "\"\"") continue;
+
+        auto& best = found[it->second.first];
+        if (it->second.second >= best.first) continue;
+        std::string value;
+        if (!convert(slots[it->second.first], raw, value, error)) return false;
+        best = {it->second.second, value};
+    }
+
+    for (size_t i = 0; i < slots.size(); i++) {
+        const Slot& slot = slots[i];
+        if (found[i].first == SIZE_MAX) {
+            if (slot.required) {
+                error = "Error: " + tool_name + " requires a " + slot.spec.key;
+                return false;
+            }
+            continue;
+        }
+        const std::string& value = found[i].second;
+        if (slot.spec.is_switch) {
+            if (value == "true") argv.push_back(slot.spec.flag);
+            continue;
+        }
+        if (!slot.spec.flag.empty()) argv.push_back(slot.spec.flag);
+        argv.push_back(value);
+    }
+    return true;
+}
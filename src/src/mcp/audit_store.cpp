@@ -0,0 +1,485 @@
+#include "mcp/audit_store.hpp"
+#include "utils/logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <strings.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// -----------------------------------------------------------------------------
+// Index file layout (host byte order, like the records)
+// -----------------------------------------------------------------------------
+
+namespace {
+
+constexpr uint32_t INDEX_MAGIC = 0x31584941;   // "AIX1"
+constexpr uint32_t INDEX_VERSION = 1;
+constexpr size_t MAX_LIMIT = 1000;
+
+struct IndexHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t segment_bytes;    // size of the .bin when indexed
+    uint64_t records;
+    int64_t min_us;
+    int64_t max_us;
+    uint32_t keys[3];          // per dimension
+    uint32_t reserved;
+    uint64_t postings;         // total posting entries
+};
+
+struct IndexKey {
+    uint64_t hash;
+    uint32_t first;            // into the postings array
+    uint32_t count;
+};
+
+uint64_t fnv64(const char* s, size_t len) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < len; i++) h = (h ^ (unsigned char)s[i]) * 1099511628211ull;
+    return h;
+}
+
+// "/x/tools/osshm_list.sh" and "osshm_list" both become "osshm_list"
+std::string command_key(const char* cmd, size_t len) {
+    std::string s(cmd, strnlen(cmd, len));
+    size_t slash = s.rfind('/');
+    if (slash != std::string::npos) s.erase(0, slash + 1);
+    if (s.size() > 3 && s.compare(s.size() - 3, 3, ".sh") == 0) s.resize(s.size() - 3);
+    return s;
+}
+
+std::string field(const char* f, size_t size) {
+    return std::string(f, strnlen(f, size));
+}
+
+int64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// "7d", "12h", "30m", "45s", epoch seconds, or a local date/time
+bool parse_time(const std::string& s, bool end_of_day, int64_t& us) {
+    if (s.empty()) return false;
+    char* end = nullptr;
+    long long n = std::strtoll(s.c_str(), &end, 10);
+    if (end != s.c_str() && *end && !end[1]) {
+        long long unit = *end == 'd' ? 86400 : *end == 'h' ? 3600 : *end == 'm' ? 60 : *end == 's' ? 1 : 0;
+        if (!unit || n < 0) return false;
+        us = now_us() - n * unit * 1000000;
+        return true;
+    }
+    if (end != s.c_str() && !*end) {
+        us = n * 1000000;
+        return true;
+    }
+    static const char* formats[] = {"%Y-%m-%d %H:%M:%S", "%Y-%m-%dT%H:%M:%S",
+                                    "%Y-%m-%d %H:%M", "%Y-%m-%dT%H:%M"};
+    struct tm tm;
+    for (const char* format : formats) {
+        memset(&tm, 0, sizeof(tm));
+        const char* rest = strptime(s.c_str(), format, &tm);
+        if (rest && !*rest) {
+            tm.tm_isdst = -1;
+            us = (int64_t)mktime(&tm) * 1000000;
+            return true;
+        }
+    }
+    memset(&tm, 0, sizeof(tm));
+    const char* rest = strptime(s.c_str(), "%Y-%m-%d", &tm);
+    if (!rest || *rest) return false;
+    // A bare date as the upper bound includes the whole day
+    if (end_of_day) tm.tm_mday++;
+    tm.tm_isdst = -1;
+    us = (int64_t)mktime(&tm) * 1000000;
+    return true;
+}
+
+} // namespace
+
+bool AuditQuery::parse(const std::vector<std::string>& args, std::string& error) {
+    for (size_t i = 0; i < args.size(); i++) {
+        const std::string& flag = args[i];
+        if (i + 1 >= args.size()) {
+            error = "Error: " + flag + " needs a value";
+            return false;
+        }
+        const std::string& value = args[++i];
+        if (flag == "--user") {
+            user = value;
+        } else if (flag == "--command") {
+            command = value;
+        } else if (flag == "--status") {
+            if (strcasecmp(value.c_str(), "ALLOWED") == 0) status = AUDIT_ALLOWED;
+            else if (strcasecmp(value.c_str(), "DENIED") == 0) status = AUDIT_DENIED;
+            else if (strcasecmp(value.c_str(), "ABORTED") == 0) status = AUDIT_ABORTED;
+            else if (strcasecmp(value.c_str(), "SUBMITTED") == 0) status = AUDIT_SUBMITTED;
+            else if (strcasecmp(value.c_str(), "OTHER") == 0) status = AUDIT_OTHER;
+            else {
+                error = "Error: status must be ALLOWED, DENIED, ABORTED, SUBMITTED or OTHER";
+                return false;
+            }
+        } else if (flag == "--since" || flag == "--until") {
+            int64_t& bound = (flag == "--since") ? since_us : until_us;
+            if (!parse_time(value, flag == "--until", bound)) {
+                error = "Error: cannot read " + flag.substr(2) + " '" + value +
+                        "' (use 7d, 12h, 30m, epoch seconds or YYYY-MM-DD[ HH:MM[:SS]])";
+                return false;
+            }
+        } else if (flag == "--limit") {
+            long n = std::atol(value.c_str());
+            if (n <= 0) {
+                error = "Error: limit must be a positive number";
+                return false;
+            }
+            limit = std::min((size_t)n, MAX_LIMIT);
+        } else {
+            error = "Error: unexpected argument '" + flag + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Sealed segments
+// -----------------------------------------------------------------------------
+
+struct AuditStore::Segment {
+    std::string name;
+    void* bin_map = MAP_FAILED;
+    size_t bin_len = 0;
+    void* idx_map = MAP_FAILED;
+    size_t idx_len = 0;
+    std::vector<char> idx_mem;          // when the .idx could not be written
+
+    const AuditRecord* recs = nullptr;
+    size_t count = 0;
+    const IndexHeader* header = nullptr;
+    const IndexKey* keys[3] = {nullptr, nullptr, nullptr};
+    const uint32_t* postings = nullptr;
+
+    ~Segment() {
+        if (bin_map != MAP_FAILED) munmap(bin_map, bin_len);
+        if (idx_map != MAP_FAILED) munmap(idx_map, idx_len);
+    }
+
+    // Point header/keys/postings into data if it is a valid index for this .bin
+    bool attach(const char* data, size_t len) {
+        if (len < sizeof(IndexHeader)) return false;
+        const IndexHeader* h = reinterpret_cast<const IndexHeader*>(data);
+        if (h->magic != INDEX_MAGIC || h->version != INDEX_VERSION ||
+            h->segment_bytes != bin_len || h->records != count) {
+            return false;
+        }
+        size_t need = sizeof(IndexHeader) +
+                      ((size_t)h->keys[0] + h->keys[1] + h->keys[2]) * sizeof(IndexKey) +
+                      h->postings * sizeof(uint32_t);
+        if (len != need) return false;
+        header = h;
+        const IndexKey* k = reinterpret_cast<const IndexKey*>(data + sizeof(IndexHeader));
+        for (int d = 0; d < 3; d++) {
+            keys[d] = k;
+            k += h->keys[d];
+        }
+        postings = reinterpret_cast<const uint32_t*>(k);
+        return true;
+    }
+
+    Postings find(int dim, uint64_t hash) const {
+        const IndexKey* begin = keys[dim];
+        const IndexKey* end = begin + header->keys[dim];
+        const IndexKey* it = std::lower_bound(begin, end, hash,
+            [](const IndexKey& k, uint64_t h) { return k.hash < h; });
+        if (it == end || it->hash != hash) return {};
+        return {postings + it->first, it->count};
+    }
+};
+
+static std::vector<char> build_index(const AuditRecord* recs, size_t count, size_t bin_len,
+                                     uint64_t (*hash)(int, const AuditRecord&)) {
+    std::map<uint64_t, std::vector<uint32_t>> keys[3];
+    IndexHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = INDEX_MAGIC;
+    h.version = INDEX_VERSION;
+    h.segment_bytes = bin_len;
+    h.records = count;
+    for (size_t i = 0; i < count; i++) {
+        if (recs[i].magic != AUDIT_MAGIC) continue;
+        if (!h.min_us || recs[i].time_us < h.min_us) h.min_us = recs[i].time_us;
+        if (recs[i].time_us > h.max_us) h.max_us = recs[i].time_us;
+        for (int d = 0; d < 3; d++) keys[d][hash(d, recs[i])].push_back((uint32_t)i);
+    }
+
+    std::vector<IndexKey> table;
+    std::vector<uint32_t> postings;
+    for (int d = 0; d < 3; d++) {
+        h.keys[d] = (uint32_t)keys[d].size();
+        for (const auto& entry : keys[d]) {
+            table.push_back({entry.first, (uint32_t)postings.size(), (uint32_t)entry.second.size()});
+            postings.insert(postings.end(), entry.second.begin(), entry.second.end());
+        }
+    }
+    h.postings = postings.size();
+
+    std::vector<char> out(sizeof(h) + table.size() * sizeof(IndexKey) + postings.size() * sizeof(uint32_t));
+    char* p = out.data();
+    memcpy(p, &h, sizeof(h));
+    p += sizeof(h);
+    if (!table.empty()) memcpy(p, table.data(), table.size() * sizeof(IndexKey));
+    p += table.size() * sizeof(IndexKey);
+    if (!postings.empty()) memcpy(p, postings.data(), postings.size() * sizeof(uint32_t));
+    return out;
+}
+
+static void* map_file(const std::string& path, size_t& len) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return MAP_FAILED;
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        len = (size_t)st.st_size;
+        map = mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    return map;
+}
+
+std::unique_ptr<AuditStore::Segment> AuditStore::open_segment(const std::string& name) {
+    auto seg = std::make_unique<Segment>();
+    seg->name = name;
+    std::string bin_path = directory + "/" + name;
+    seg->bin_map = map_file(bin_path, seg->bin_len);
+    if (seg->bin_map != MAP_FAILED) {
+        seg->recs = static_cast<const AuditRecord*>(seg->bin_map);
+        seg->count = seg->bin_len / sizeof(AuditRecord);
+    }
+
+    std::string idx_path = bin_path.substr(0, bin_path.size() - 4) + ".idx";
+    seg->idx_map = map_file(idx_path, seg->idx_len);
+    if (seg->idx_map != MAP_FAILED && seg->attach(static_cast<const char*>(seg->idx_map), seg->idx_len)) {
+        return seg;
+    }
+    if (seg->idx_map != MAP_FAILED) munmap(seg->idx_map, seg->idx_len);
+    seg->idx_map = MAP_FAILED;
+
+    // Missing or stale: build it, and keep it for next time if we can
+    std::vector<char> index = build_index(seg->recs, seg->count, seg->bin_len,
+        [](int d, const AuditRecord& rec) { return key_hash((Dimension)d, rec); });
+    std::string tmp = idx_path + ".tmp" + std::to_string(getpid());
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool saved = fd >= 0 && write(fd, index.data(), index.size()) == (ssize_t)index.size();
+    if (fd >= 0) close(fd);
+    saved = saved && rename(tmp.c_str(), idx_path.c_str()) == 0;
+    if (!saved) unlink(tmp.c_str());
+    utils::Logger::debug("AuditStore: indexed " + name + " (" + std::to_string(seg->count) + " records" +
+                         (saved ? "" : ", kept in memory") + ")");
+    if (saved) {
+        seg->idx_map = map_file(idx_path, seg->idx_len);
+        if (seg->idx_map != MAP_FAILED && seg->attach(static_cast<const char*>(seg->idx_map), seg->idx_len)) {
+            return seg;
+        }
+    }
+    seg->idx_mem = std::move(index);
+    seg->attach(seg->idx_mem.data(), seg->idx_mem.size());
+    return seg;
+}
+
+void AuditStore::refresh_segments() {
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) return;
+    std::map<std::string, std::unique_ptr<Segment>> current;
+    const size_t prefix_len = strlen(AUDIT_SEGMENT_PREFIX);
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() <= prefix_len + 4 || name.compare(0, prefix_len, AUDIT_SEGMENT_PREFIX) != 0 ||
+            name.compare(name.size() - 4, 4, ".bin") != 0) {
+            continue;
+        }
+        auto it = segments.find(name);
+        current[name] = (it != segments.end()) ? std::move(it->second) : open_segment(name);
+    }
+    closedir(dir);
+    segments = std::move(current);   // drops segments that were deleted
+}
+
+// -----------------------------------------------------------------------------
+// AuditStore
+// -----------------------------------------------------------------------------
+
+AuditStore::AuditStore(const std::string& directory) : directory(directory) {}
+
+AuditStore::~AuditStore() = default;
+
+uint64_t AuditStore::key_hash(Dimension dim, const AuditRecord& rec) {
+    if (dim == DIM_STATUS) return rec.status;
+    if (dim == DIM_USER) return fnv64(rec.user, strnlen(rec.user, sizeof(rec.user)));
+    std::string cmd = command_key(rec.cmd, sizeof(rec.cmd));
+    return fnv64(cmd.data(), cmd.size());
+}
+
+uint64_t AuditStore::query_hash(Dimension dim, const AuditQuery& query) {
+    if (dim == DIM_STATUS) return (uint64_t)query.status;
+    if (dim == DIM_USER) return fnv64(query.user.data(), query.user.size());
+    std::string cmd = command_key(query.command.c_str(), query.command.size());
+    return fnv64(cmd.data(), cmd.size());
+}
+
+bool AuditStore::matches(const AuditRecord& rec, const AuditQuery& query) {
+    if (rec.magic != AUDIT_MAGIC) return false;
+    if (rec.time_us < query.since_us || rec.time_us >= query.until_us) return false;
+    if (query.status >= 0 && rec.status != query.status) return false;
+    if (!query.user.empty() && field(rec.user, sizeof(rec.user)) != query.user) return false;
+    if (!query.command.empty()) {
+        if (query.command.find('/') != std::string::npos) {
+            if (field(rec.cmd, sizeof(rec.cmd)) != query.command) return false;
+        } else if (command_key(rec.cmd, sizeof(rec.cmd)) != command_key(query.command.c_str(), query.command.size())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Newest first: walk the shortest posting list (or every record) backwards
+void AuditStore::collect(const AuditRecord* recs, size_t count, const std::vector<Postings>& lists,
+                         const AuditQuery& query, std::vector<AuditRecord>& out, size_t want,
+                         size_t& candidates) {
+    if (lists.empty()) {
+        for (size_t i = count; i-- > 0 && out.size() < want;) {
+            candidates++;
+            if (matches(recs[i], query)) out.push_back(recs[i]);
+        }
+        return;
+    }
+    const Postings* shortest = &lists[0];
+    for (const auto& list : lists) {
+        if (list.count < shortest->count) shortest = &list;
+    }
+    for (size_t i = shortest->count; i-- > 0 && out.size() < want;) {
+        uint32_t id = shortest->ids[i];
+        if (id >= count) continue;
+        candidates++;
+        if (matches(recs[id], query)) out.push_back(recs[id]);
+    }
+}
+
+void AuditStore::update_live(const AuditRecord* recs, size_t count, const struct stat& st) {
+    if (st.st_dev != live.dev || st.st_ino != live.ino || count < live.records) {
+        live = LiveIndex();
+        live.dev = st.st_dev;
+        live.ino = st.st_ino;
+    }
+    for (size_t i = live.records; i < count; i++) {
+        if (recs[i].magic != AUDIT_MAGIC) continue;
+        if (!live.min_us || recs[i].time_us < live.min_us) live.min_us = recs[i].time_us;
+        if (recs[i].time_us > live.max_us) live.max_us = recs[i].time_us;
+        for (int d = 0; d < DIM_COUNT; d++) {
+            live.keys[d][key_hash((Dimension)d, recs[i])].push_back((uint32_t)i);
+        }
+    }
+    live.records = count;
+}
+
+std::vector<AuditRecord> AuditStore::query(const AuditQuery& query, bool* more,
+                                           size_t* segments_read, size_t* candidates) {
+    std::lock_guard<std::mutex> lock(mutex);
+    refresh_segments();
+
+    // One extra record tells whether the limit cut anything off
+    const size_t want = query.limit + 1;
+    std::vector<AuditRecord> out;
+    size_t read = 0, seen = 0;
+    bool filters[DIM_COUNT] = {!query.user.empty(), !query.command.empty(), query.status >= 0};
+
+    // The live file holds the newest records
+    std::string live_path = directory + "/" + AUDIT_FILE;
+    size_t live_len = 0;
+    void* live_map = map_file(live_path, live_len);
+    struct stat st;
+    if (live_map != MAP_FAILED && stat(live_path.c_str(), &st) == 0) {
+        const AuditRecord* recs = static_cast<const AuditRecord*>(live_map);
+        size_t count = live_len / sizeof(AuditRecord);
+        update_live(recs, count, st);
+        if (live.max_us >= query.since_us && live.min_us < query.until_us) {
+            std::vector<Postings> lists;
+            bool empty = false;
+            for (int d = 0; d < DIM_COUNT && !empty; d++) {
+                if (!filters[d]) continue;
+                auto it = live.keys[d].find(query_hash((Dimension)d, query));
+                if (it == live.keys[d].end()) empty = true;
+                else lists.push_back({it->second.data(), it->second.size()});
+            }
+            read++;
+            if (!empty) collect(recs, count, lists, query, out, want, seen);
+        }
+    }
+    if (live_map != MAP_FAILED) munmap(live_map, live_len);
+
+    // Then the sealed segments, newest first, skipping those outside the range
+    std::vector<const Segment*> order;
+    for (const auto& entry : segments) {
+        const Segment* seg = entry.second.get();
+        if (!seg->header || !seg->header->records) continue;
+        if (seg->header->max_us < query.since_us || seg->header->min_us >= query.until_us) continue;
+        order.push_back(seg);
+    }
+    std::sort(order.begin(), order.end(), [](const Segment* a, const Segment* b) {
+        return a->header->max_us > b->header->max_us;
+    });
+    for (const Segment* seg : order) {
+        if (out.size() >= want) break;
+        std::vector<Postings> lists;
+        bool empty = false;
+        for (int d = 0; d < DIM_COUNT && !empty; d++) {
+            if (!filters[d]) continue;
+            Postings p = seg->find(d, query_hash((Dimension)d, query));
+            if (!p.count) empty = true;
+            else lists.push_back(p);
+        }
+        read++;
+        if (!empty) collect(seg->recs, seg->count, lists, query, out, want, seen);
+    }
+
+    std::stable_sort(out.begin(), out.end(), [](const AuditRecord& a, const AuditRecord& b) {
+        return a.time_us > b.time_us;
+    });
+    if (more) *more = out.size() > query.limit;
+    if (out.size() > query.limit) out.resize(query.limit);
+    if (segments_read) *segments_read = read;
+    if (candidates) *candidates = seen;
+    return out;
+}
+
+std::string AuditStore::run(const AuditQuery& query) {
+    auto start = std::chrono::steady_clock::now();
+    bool more = false;
+    size_t read = 0, seen = 0;
+    std::vector<AuditRecord> records = this->query(query, &more, &read, &seen);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    char summary[256];
+    if (records.empty()) {
+        snprintf(summary, sizeof(summary), "No audit records match (%zu files, %zu records checked, %.2f ms)\n",
+                 read, seen, ms);
+        return summary;
+    }
+    snprintf(summary, sizeof(summary), "%zu audit records, newest first%s (%zu files, %zu records checked, %.2f ms)\n",
+             records.size(), more ? "; more match, narrow the filters or raise limit" : "",
+             read, seen, ms);
+    std::string out = summary;
+    char line[512];
+    for (const auto& rec : records) {
+        audit_format(&rec, line, sizeof(line));
+        out += line;
+    }
+    return out;
+}
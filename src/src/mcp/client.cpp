@@ -13,14 +13,24 @@ MCPClient::MCPClient(std::unique_ptr<LLMProvider> provider) : llm(std::move(prov
 
 MCPClient::~MCPClient() = default;
 
-void MCPClient::addServer(const std::string& name, const std::vector<std::string>& command) {
+void MCPClient::addServer(const std::string& name, const std::vector<std::string>& command, int timeout_ms) {
     auto server = std::make_unique<MCPServer>(name);
+    server->setTimeout(timeout_ms);
     if (server->connect(command)) {
         servers.push_back(std::move(server));
         registerTools();
     }
 }
 
+void MCPClient::addRemoteServer(const std::string& name, const std::string& url, int timeout_ms) {
+    auto server = std::make_unique<MCPServer>(name);
+    server->setTimeout(timeout_ms);
+    if (server->connectRemote(url)) {
+        servers.push_back(std::move(server));
+        registerTools();
+    }
+}
+
 void MCPClient::setProvider(std::unique_ptr<LLMProvider> new_provider) {
     if (new_provider) {
         llm = std::move(new_provider);
@@ -72,7 +82,11 @@ void MCPClient::registerTools() {
     }
 }
 
-std::string MCPClient::chat(const std::string& user_message, const std::vector<std::map<std::string, std::string>>& history) {
-    if (!llm) return "Error: No LLM provider";
+ChatResponse MCPClient::chat(const std::string& user_message, const Conversation& history) {
+    if (!llm) {
+        ChatResponse response;
+        response.error = "No LLM provider";
+        return response;
+    }
     return llm->chat(user_message, history);
 }
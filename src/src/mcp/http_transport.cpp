@@ -0,0 +1,200 @@
+#include "mcp/http_transport.hpp"
+#include "utils/logger.hpp"
+#include "utils/cancel.hpp"
+#include <curl/curl.h>
+#include <strings.h>
+
+HttpTransport::HttpTransport(const std::string& url)
+    : url(url), curl(nullptr), abortable(true), connections_opened(0) {}
+
+HttpTransport::~HttpTransport() {
+    close();
+}
+
+bool HttpTransport::open() {
+    curl = curl_easy_init();
+    if (!curl) return false;
+
+    CURL* h = static_cast<CURL*>(curl);
+    curl_easy_setopt(h, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(h, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(h, CURLOPT_WRITEDATA, this);
+    curl_easy_setopt(h, CURLOPT_HEADERFUNCTION, header_callback);
+    curl_easy_setopt(h, CURLOPT_HEADERDATA, this);
+    curl_easy_setopt(h, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(h, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(h, CURLOPT_CONNECTTIMEOUT, 10L);
+    curl_easy_setopt(h, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(h, CURLOPT_XFERINFOFUNCTION, progress_callback);
+    curl_easy_setopt(h, CURLOPT_XFERINFODATA, this);
+    curl_easy_setopt(h, CURLOPT_NOPROGRESS, 0L);
+    return true;
+}
+
+size_t HttpTransport::header_callback(char* buffer, size_t size, size_t nitems, void* userp) {
+    HttpTransport* self = static_cast<HttpTransport*>(userp);
+    size_t len = size * nitems;
+    std::string header(buffer, len);
+    while (!header.empty() && (header.back() == '\n' || header.back() == '\r')) header.pop_back();
+
+    size_t colon = header.find(':');
+    if (colon == std::string::npos) return len;
+
+    std::string key = header.substr(0, colon);
+    std::string value = header.substr(colon + 1);
+    size_t first = value.find_first_not_of(' ');
+    value = (first == std::string::npos) ? "" : value.substr(first);
+
+    if (strcasecmp(key.c_str(), "Mcp-Session-Id") == 0) {
+        self->session_id = value;
+    } else if (strcasecmp(key.c_str(), "Content-Type") == 0) {
+        self->content_type = value;
+    }
+    return len;
+}
+
+int HttpTransport::progress_callback(void* userp, long long, long long, long long, long long) {
+    // Non-zero aborts the transfer with CURLE_ABORTED_BY_CALLBACK. Notifications
+    // are not abortable, so notifications/cancelled still goes out after Ctrl-C.
+    HttpTransport* self = static_cast<HttpTransport*>(userp);
+    return (self->abortable && utils::CancelScope::requested()) ? 1 : 0;
+}
+
+size_t HttpTransport::write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
+    static_cast<HttpTransport*>(userp)->feed(static_cast<const char*>(contents), size * nmemb);
+    return size * nmemb;
+}
+
+void HttpTransport::feed(const char* data, size_t len) {
+    if (content_type.find("text/event-stream") == std::string::npos) {
+        body.append(data, len);
+        return;
+    }
+
+    // SSE: split on line boundaries, dispatch an event at every blank line
+    for (size_t i = 0; i < len; i++) {
+        char c = data[i];
+        if (c == '\n') {
+            if (!sse_line.empty() && sse_line.back() == '\r') sse_line.pop_back();
+            feed_sse_line(sse_line);
+            sse_line.clear();
+        } else {
+            sse_line += c;
+        }
+    }
+}
+
+void HttpTransport::feed_sse_line(const std::string& line) {
+    if (line.empty()) {
+        if (!sse_data.empty()) inbox.push_back(sse_data);
+        sse_data.clear();
+        return;
+    }
+    if (line.compare(0, 5, "data:") != 0) return; // event:, id:, retry:, comments
+
+    std::string value = line.substr(5);
+    if (!value.empty() && value[0] == ' ') value.erase(0, 1);
+    if (!sse_data.empty()) sse_data += ' ';
+    sse_data += value;
+}
+
+bool HttpTransport::send(const std::string& message, Deadline deadline, bool abortable) {
+    if (!curl) return false;
+    CURL* h = static_cast<CURL*>(curl);
+    this->abortable = abortable;
+
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now()).count();
+    if (remaining <= 0) return false;
+    curl_easy_setopt(h, CURLOPT_TIMEOUT_MS, (long)remaining);
+
+    content_type.clear();
+    body.clear();
+    sse_line.clear();
+    sse_data.clear();
+
+    struct curl_slist* headers = nullptr;
+    headers = curl_slist_append(headers, "Content-Type: application/json");
+    headers = curl_slist_append(headers, "Accept: application/json, text/event-stream");
+    if (!session_id.empty()) {
+        headers = curl_slist_append(headers, ("Mcp-Session-Id: " + session_id).c_str());
+    }
+
+    curl_easy_setopt(h, CURLOPT_POST, 1L);
+    curl_easy_setopt(h, CURLOPT_POSTFIELDS, message.c_str());
+    curl_easy_setopt(h, CURLOPT_POSTFIELDSIZE, (long)message.length());
+    curl_easy_setopt(h, CURLOPT_HTTPHEADER, headers);
+
+    CURLcode res = curl_easy_perform(h);
+    curl_slist_free_all(headers);
+    curl_easy_setopt(h, CURLOPT_HTTPHEADER, nullptr);
+
+    long new_connections = 0;
+    curl_easy_getinfo(h, CURLINFO_NUM_CONNECTS, &new_connections);
+    connections_opened += new_connections;
+
+    if (res != CURLE_OK) {
+        utils::Logger::error("[http] " + url + ": " + curl_easy_strerror(res));
+        return false;
+    }
+
+    long status = 0;
+    curl_easy_getinfo(h, CURLINFO_RESPONSE_CODE, &status);
+    if (status == 404 && !session_id.empty()) {
+        utils::Logger::error("[http] session " + session_id + " expired on " + url);
+        session_id.clear();
+        return false;
+    }
+    if (status >= 400) {
+        utils::Logger::error("[http] " + url + " returned HTTP " + std::to_string(status));
+        return false;
+    }
+
+    // Flush whatever the reply carried into the inbox
+    if (!sse_line.empty()) feed_sse_line(sse_line);
+    feed_sse_line("");
+    if (!body.empty()) {
+        for (char& c : body) {
+            if (c == '\n' || c == '\r') c = ' ';
+        }
+        inbox.push_back(body);
+    }
+
+    utils::Logger::debug("[http] " + url + " HTTP " + std::to_string(status) +
+                         " connections opened: " + std::to_string(connections_opened));
+    return true;
+}
+
+RecvStatus HttpTransport::receive(std::string& line, Deadline) {
+    // The whole reply was already consumed inside send()
+    if (inbox.empty()) return RecvStatus::Closed;
+    line = inbox.front();
+    inbox.pop_front();
+    return RecvStatus::Line;
+}
+
+void HttpTransport::close() {
+    if (!curl) return;
+    CURL* h = static_cast<CURL*>(curl);
+
+    // Explicitly end the session so the server can free its state
+    if (!session_id.empty()) {
+        struct curl_slist* headers = nullptr;
+        headers = curl_slist_append(headers, ("Mcp-Session-Id: " + session_id).c_str());
+        curl_easy_setopt(h, CURLOPT_CUSTOMREQUEST, "DELETE");
+        curl_easy_setopt(h, CURLOPT_HTTPGET, 1L);
+        curl_easy_setopt(h, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(h, CURLOPT_TIMEOUT_MS, 5000L);
+        curl_easy_perform(h);
+        curl_slist_free_all(headers);
+        session_id.clear();
+    }
+
+    curl_easy_cleanup(h);
+    curl = nullptr;
+    inbox.clear();
+}
+
+std::string HttpTransport::describe() const {
+    return "http: " + url;
+}
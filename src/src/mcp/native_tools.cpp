@@ -0,0 +1,562 @@
+#include "mcp/native_tools.hpp"
+#include "mcp/audit_store.hpp"
+#include "utils/logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// -----------------------------------------------------------------------------
+// ProcReader
+// -----------------------------------------------------------------------------
+
+ProcReader::ProcReader()
+    : proc_fd(open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC)),
+      hertz(sysconf(_SC_CLK_TCK)), page_kb(sysconf(_SC_PAGESIZE) / 1024), pid_width(5) {
+    if (proc_fd < 0) {
+        utils::Logger::error("ProcReader: cannot open /proc: " + std::string(strerror(errno)));
+        return;
+    }
+    std::string buf;
+    if (read_file("sys/kernel/pid_max", buf)) {
+        long pid_max = std::atol(buf.c_str());
+        int digits = (int)std::to_string(pid_max > 1 ? pid_max - 1 : 1).length();
+        pid_width = std::max(5, digits);
+    }
+}
+
+ProcReader::~ProcReader() {
+    if (proc_fd >= 0) close(proc_fd);
+}
+
+bool ProcReader::read_file(const char* rel_path, std::string& buf) const {
+    buf.clear();
+    int fd = openat(proc_fd, rel_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    char chunk[4096];
+    while (true) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        buf.append(chunk, n);
+    }
+    close(fd);
+    return true;
+}
+
+bool ProcReader::read(int pid, ProcInfo& info, bool with_cmdline, bool with_uid) const {
+    // Buffers are reused across calls; each worker thread has its own
+    thread_local std::string buf;
+    char path[64];
+
+    snprintf(path, sizeof(path), "%d/stat", pid);
+    if (!read_file(path, buf) || buf.empty()) return false;
+
+    // comm may contain spaces and parentheses; it ends at the last ')'
+    size_t open_paren = buf.find('(');
+    size_t close_paren = buf.rfind(')');
+    if (open_paren == std::string::npos || close_paren == std::string::npos || close_paren < open_paren) {
+        return false;
+    }
+    info.pid = pid;
+    info.comm = buf.substr(open_paren + 1, close_paren - open_paren - 1);
+
+    // Fields after comm, numbered as in proc(5): 3 state, 4 ppid,
+    // 14 utime, 15 stime, 22 starttime, 24 rss
+    const char* p = buf.c_str() + close_paren + 2;
+    char* end = nullptr;
+    info.state = *p;
+    p += 1;
+    int field = 4;
+    while (*p && field <= 24) {
+        unsigned long long value = std::strtoull(p, &end, 10);
+        if (end == p) break;
+        if (field == 4) info.ppid = (int)value;
+        else if (field == 14) info.utime = value;
+        else if (field == 15) info.stime = value;
+        else if (field == 22) info.starttime = value;
+        else if (field == 24) info.rss_pages = (long)value;
+        p = end;
+        field++;
+    }
+
+    if (with_uid) {
+        snprintf(path, sizeof(path), "%d/status", pid);
+        if (read_file(path, buf)) {
+            size_t pos = buf.find("\nUid:");
+            if (pos != std::string::npos) {
+                // Uid: real effective saved fs
+                char* q = nullptr;
+                std::strtoul(buf.c_str() + pos + 5, &q, 10);
+                info.euid = (uid_t)std::strtoul(q, nullptr, 10);
+            }
+        }
+    }
+
+    info.cmdline.clear();
+    if (with_cmdline) {
+        snprintf(path, sizeof(path), "%d/cmdline", pid);
+        if (read_file(path, buf)) {
+            while (!buf.empty() && buf.back() == '\0') buf.pop_back();
+            info.cmdline.reserve(buf.size());
+            for (char c : buf) {
+                unsigned char u = (unsigned char)c;
+                if (c == '\0') info.cmdline += ' ';
+                else if (u < 0x20 || u >= 0x7f) info.cmdline += '?';
+                else info.cmdline += c;
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<int> ProcReader::pids() const {
+    std::vector<int> result;
+    int fd = openat(proc_fd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return result;
+    DIR* dir = fdopendir(fd);
+    if (!dir) {
+        close(fd);
+        return result;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+        const char* name = entry->d_name;
+        if (*name < '1' || *name > '9') continue;
+        char* end = nullptr;
+        long pid = std::strtol(name, &end, 10);
+        if (*end == '\0') result.push_back((int)pid);
+    }
+    closedir(dir);
+    return result;
+}
+
+double ProcReader::uptime() const {
+    thread_local std::string buf;
+    if (!read_file("uptime", buf)) return 0.0;
+    return std::strtod(buf.c_str(), nullptr);
+}
+
+unsigned long long ProcReader::memTotalKb() const {
+    thread_local std::string buf;
+    if (!read_file("meminfo", buf)) return 0;
+    size_t pos = buf.find("MemTotal:");
+    if (pos == std::string::npos) return 0;
+    return std::strtoull(buf.c_str() + pos + 9, nullptr, 10);
+}
+
+std::string ProcReader::loadAverage() const {
+    thread_local std::string buf;
+    if (!read_file("loadavg", buf)) return "";
+    // "0.14 0.23 0.17 1/123 4567" -> first three fields
+    size_t end = 0;
+    for (int field = 0; field < 3 && end != std::string::npos; field++) {
+        end = buf.find(' ', end + (field ? 1 : 0));
+    }
+    return buf.substr(0, end);
+}
+
+// -----------------------------------------------------------------------------
+// ProcSnapshotService
+// -----------------------------------------------------------------------------
+
+long ProcSnapshot::find(int pid) const {
+    auto it = by_pid.find(pid);
+    return it == by_pid.end() ? -1 : (long)it->second;
+}
+
+ProcSnapshotService::ProcSnapshotService(const ProcReader& reader, int ttl_ms)
+    : reader(reader), ttl(ttl_ms) {}
+
+void ProcSnapshotService::setTtl(int ttl_ms) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    ttl = std::chrono::milliseconds(ttl_ms);
+}
+
+std::shared_ptr<const ProcSnapshot> ProcSnapshotService::get() {
+    auto fresh = [this](const std::shared_ptr<const ProcSnapshot>& snap) {
+        return snap && std::chrono::steady_clock::now() - snap->taken < ttl;
+    };
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        if (fresh(current)) return current;
+    }
+
+    // One thread rescans; the others wait here and reuse its result
+    std::lock_guard<std::mutex> scanning(scan_mutex);
+    std::shared_ptr<const ProcSnapshot> previous;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        if (fresh(current)) return current;
+        previous = current;
+    }
+    // %CPU averaged over minutes (first scan, idle spell) says little about
+    // now; measure over a short fresh window instead
+    if (!previous || std::chrono::steady_clock::now() - previous->taken > MAX_CPU_WINDOW) {
+        previous = scan(nullptr);
+        std::this_thread::sleep_for(CPU_SAMPLE);
+    }
+    auto next = scan(previous);
+    std::lock_guard<std::mutex> lock(state_mutex);
+    current = next;
+    return next;
+}
+
+std::vector<ProcInfo> ProcSnapshotService::read_range(const std::vector<int>& pids, size_t begin, size_t end) const {
+    std::vector<ProcInfo> procs;
+    procs.reserve(end - begin);
+    for (size_t i = begin; i < end; i++) {
+        ProcInfo info;
+        if (reader.read(pids[i], info)) procs.push_back(std::move(info));
+    }
+    return procs;
+}
+
+std::shared_ptr<const ProcSnapshot> ProcSnapshotService::scan(const std::shared_ptr<const ProcSnapshot>& previous) const {
+    auto snap = std::make_shared<ProcSnapshot>();
+    snap->uptime = reader.uptime();
+    snap->mem_total_kb = reader.memTotalKb();
+    std::vector<int> pids = reader.pids();
+
+    // Large process tables are read in contiguous slices, one per thread,
+    // and joined back in directory order
+    size_t threads = 1;
+    if (pids.size() >= PARALLEL_MIN_PIDS) {
+        threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), 8);
+    }
+    if (threads <= 1) {
+        snap->procs = read_range(pids, 0, pids.size());
+    } else {
+        std::vector<std::vector<ProcInfo>> parts(threads);
+        std::vector<std::thread> workers;
+        size_t slice = (pids.size() + threads - 1) / threads;
+        for (size_t t = 0; t < threads; t++) {
+            size_t begin = std::min(pids.size(), t * slice);
+            size_t end = std::min(pids.size(), begin + slice);
+            workers.emplace_back([this, &pids, &parts, t, begin, end] { parts[t] = read_range(pids, begin, end); });
+        }
+        for (auto& w : workers) w.join();
+        for (auto& part : parts) {
+            for (auto& info : part) snap->procs.push_back(std::move(info));
+        }
+    }
+    snap->taken = std::chrono::steady_clock::now();
+
+    // %CPU: ticks used since the previous scan when the same process (same
+    // start time) was seen there, else the lifetime average like ps
+    double hz = (double)reader.ticksPerSecond();
+    if (previous) snap->window_s = std::chrono::duration<double>(snap->taken - previous->taken).count();
+    snap->cpu_pct.resize(snap->procs.size());
+    snap->by_pid.reserve(snap->procs.size());
+    for (size_t i = 0; i < snap->procs.size(); i++) {
+        const ProcInfo& p = snap->procs[i];
+        snap->by_pid[p.pid] = i;
+        unsigned long long ticks = p.utime + p.stime;
+
+        long prev = previous ? previous->find(p.pid) : -1;
+        if (prev >= 0 && snap->window_s > 0 && previous->procs[prev].starttime == p.starttime) {
+            const ProcInfo& old = previous->procs[prev];
+            unsigned long long old_ticks = old.utime + old.stime;
+            double used = ticks >= old_ticks ? (double)(ticks - old_ticks) : 0.0;
+            snap->cpu_pct[i] = used / hz / snap->window_s * 100.0;
+        } else {
+            double secs = snap->uptime - (double)p.starttime / hz;
+            snap->cpu_pct[i] = secs > 0 ? (double)ticks / hz / secs * 100.0 : 0.0;
+        }
+    }
+    return snap;
+}
+
+// -----------------------------------------------------------------------------
+// ps-compatible formatting
+// -----------------------------------------------------------------------------
+
+namespace native_tools {
+
+static const ProcReader& reader() {
+    static ProcReader instance;
+    return instance;
+}
+
+static ProcSnapshotService& snapshots() {
+    static ProcSnapshotService instance(reader());
+    return instance;
+}
+
+void prime() {
+    if (!reader().ok()) return;
+    std::thread([] { snapshots().get(); }).detach();
+}
+
+void setSnapshotTtl(int ttl_ms) {
+    snapshots().setTtl(ttl_ms);
+}
+
+static bool parse_pid(const std::string& s, int& pid) {
+    if (s.empty() || s.size() > 9) return false;
+    for (char c : s) {
+        if (c < '0' || c > '9') return false;
+    }
+    pid = std::atoi(s.c_str());
+    return pid > 0;
+}
+
+static double elapsed_seconds(const ProcReader& r, const ProcInfo& p, double uptime) {
+    double secs = uptime - (double)p.starttime / r.ticksPerSecond();
+    return secs > 0 ? secs : 0;
+}
+
+// ps prints %CPU from a per-mille integer
+static unsigned long long permille(double pct) {
+    return pct > 0 ? (unsigned long long)(pct * 10.0) : 0;
+}
+
+static std::string fmt_pcpu(unsigned long long pcpu) {
+    char out[48];   // fits any 64-bit value
+    if (pcpu > 999) snprintf(out, sizeof(out), "%4llu", pcpu / 10);
+    else snprintf(out, sizeof(out), "%2llu.%llu", pcpu / 10, pcpu % 10);
+    return out;
+}
+
+static std::string fmt_pmem(const ProcReader& r, const ProcInfo& p, unsigned long long mem_total) {
+    unsigned long long pmem = mem_total ? (unsigned long long)p.rss_pages * r.pageKb() * 1000ULL / mem_total : 0;
+    char out[48];
+    snprintf(out, sizeof(out), "%2llu.%llu", pmem / 10, pmem % 10);
+    return out;
+}
+
+// [[dd-]hh:]mm:ss
+static std::string fmt_etime(double secs) {
+    unsigned long t = (unsigned long)secs;
+    unsigned ss = t % 60; t /= 60;
+    unsigned mm = t % 60; t /= 60;
+    unsigned hh = t % 24; t /= 24;
+    unsigned long dd = t;
+    char out[32];
+    if (dd) snprintf(out, sizeof(out), "%lu-%02u:%02u:%02u", dd, hh, mm, ss);
+    else if (hh) snprintf(out, sizeof(out), "%02u:%02u:%02u", hh, mm, ss);
+    else snprintf(out, sizeof(out), "%02u:%02u", mm, ss);
+    return out;
+}
+
+static std::string fmt_cmd(const ProcInfo& p) {
+    return p.cmdline.empty() ? "[" + p.comm + "]" : p.cmdline;
+}
+
+static void append_row(std::string& out, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+static void append_row(std::string& out, const char* fmt, ...) {
+    char line[512];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    out += line;
+}
+
+// Snapshot indices ordered by a key, descending; ties keep /proc order
+template <typename Key>
+static std::vector<size_t> ranked(const ProcSnapshot& snap, Key key) {
+    std::vector<size_t> order(snap.procs.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return key(a) > key(b); });
+    return order;
+}
+
+// ps -eo pid,ppid,state,%cpu,%mem,etime,cmd --sort=-%cpu
+static bool osps(const ProcReader& r, const ProcSnapshot& snap, std::string& out) {
+    if (snap.procs.empty()) return false;
+
+    int w = r.pidWidth();
+    append_row(out, "%*s %*s S %%CPU %%MEM     ELAPSED CMD\n", w, "PID", w, "PPID");
+    for (size_t i : ranked(snap, [&](size_t k) { return snap.cpu_pct[k]; })) {
+        const ProcInfo& p = snap.procs[i];
+        append_row(out, "%*d %*d %c %s %s %11s ", w, p.pid, w, p.ppid, p.state,
+                   fmt_pcpu(permille(snap.cpu_pct[i])).c_str(), fmt_pmem(r, p, snap.mem_total_kb).c_str(),
+                   fmt_etime(elapsed_seconds(r, p, snap.uptime)).c_str());
+        out += fmt_cmd(p);
+        out += '\n';
+    }
+    return true;
+}
+
+// uptime -p, /proc/loadavg, and the top 5 of
+// ps -eo pid,comm,%cpu --sort=-%cpu / ps -eo pid,comm,%mem --sort=-%mem
+static bool osuptime_plus(const ProcReader& r, const ProcSnapshot& snap, std::string& out) {
+    if (snap.procs.empty()) return false;
+
+    static const struct { unsigned long secs; const char* unit; } units[] = {
+        {365UL * 86400, "year"}, {7 * 86400, "week"}, {86400, "day"}, {3600, "hour"}, {60, "minute"}};
+    unsigned long t = (unsigned long)snap.uptime;
+    std::string pretty;
+    for (const auto& u : units) {
+        unsigned long n = t / u.secs;
+        t %= u.secs;
+        if (n == 0 && !(u.secs == 60 && pretty.empty())) continue;
+        pretty += (pretty.empty() ? "" : ", ") + std::to_string(n) + " " + u.unit + (n == 1 ? "" : "s");
+    }
+    out += "Uptime:\n  up " + pretty + "\n";
+
+    std::string load = r.loadAverage();
+    out += "Load average: " + (load.empty() ? std::string("not available") : load) + "\n";
+
+    int w = r.pidWidth();
+    auto top5 = [&](const char* title, const char* column, auto key, auto value) {
+        out += title;
+        append_row(out, "%*s %-15s %s\n", w, "PID", "COMMAND", column);
+        auto order = ranked(snap, key);
+        for (size_t n = 0; n < order.size() && n < 5; n++) {
+            const ProcInfo& p = snap.procs[order[n]];
+            append_row(out, "%*d %-15.15s %s\n", w, p.pid, p.comm.c_str(), value(order[n]).c_str());
+        }
+    };
+    top5("Top 5 CPU processes:\n", "%CPU",
+         [&](size_t i) { return snap.cpu_pct[i]; },
+         [&](size_t i) { return fmt_pcpu(permille(snap.cpu_pct[i])); });
+    top5("Top 5 MEM processes:\n", "%MEM",
+         [&](size_t i) { return snap.procs[i].rss_pages; },
+         [&](size_t i) { return fmt_pmem(r, snap.procs[i], snap.mem_total_kb); });
+    return true;
+}
+
+// ps -o pid,ppid,uid,%cpu,%mem,state,comm -p PID
+static bool process_info(const ProcReader& r, int pid, std::string& out) {
+    int w = r.pidWidth();
+    append_row(out, "%*s %*s   UID %%CPU %%MEM S COMMAND\n", w, "PID", w, "PPID");
+    ProcInfo p;
+    if (!r.read(pid, p, false, true)) return true; // ps prints just the header
+
+    // %CPU over the snapshot window when the process is in it
+    auto snap = snapshots().get();
+    long i = snap->find(pid);
+    double pct;
+    if (i >= 0 && snap->procs[i].starttime == p.starttime) {
+        pct = snap->cpu_pct[i];
+    } else {
+        double secs = elapsed_seconds(r, p, snap->uptime);
+        pct = secs > 0 ? (double)(p.utime + p.stime) / r.ticksPerSecond() / secs * 100.0 : 0.0;
+    }
+    append_row(out, "%*d %*d %5u %s %s %c ", w, p.pid, w, p.ppid, (unsigned)p.euid,
+               fmt_pcpu(permille(pct)).c_str(), fmt_pmem(r, p, snap->mem_total_kb).c_str(), p.state);
+    out += p.comm + "\n";
+    return true;
+}
+
+// ps -o pid,ppid,state,comm -p PID
+// Reads the process directly: the state must not be up to a TTL old.
+static bool process_state(const ProcReader& r, int pid, std::string& out) {
+    int w = r.pidWidth();
+    append_row(out, "%*s %*s S COMMAND\n", w, "PID", w, "PPID");
+    ProcInfo p;
+    if (!r.read(pid, p, false)) return true;
+    append_row(out, "%*d %*d %c ", w, p.pid, w, p.ppid, p.state);
+    out += p.comm + "\n";
+    return true;
+}
+
+// Index of pid in snap if it is the same process /proc has now, else -1.
+// The snapshot can be a full TTL old, so /proc decides whether pid exists.
+static long live_index(const ProcReader& r, const ProcSnapshot& snap, int pid, bool& exists) {
+    ProcInfo live;
+    exists = r.read(pid, live, false);
+    long i = snap.find(pid);
+    return (exists && i >= 0 && snap.procs[i].starttime == live.starttime) ? i : -1;
+}
+
+static std::vector<const ProcInfo*> children_of(const ProcSnapshot& snap, int pid) {
+    std::vector<const ProcInfo*> children;
+    for (const auto& p : snap.procs) {
+        if (p.ppid == pid) children.push_back(&p);
+    }
+    return children;
+}
+
+// ps -o pid,ppid,comm --forest --ppid PID
+static bool osproc_children_list(const ProcReader& r, const ProcSnapshot& snap, int pid, std::string& out) {
+    // Gone: the script reports it. Started after the scan: the script sees it.
+    bool exists = false;
+    if (live_index(r, snap, pid, exists) < 0) return false;
+
+    // The matches are siblings, so --forest lists them flat, newest first
+    std::vector<const ProcInfo*> children = children_of(snap, pid);
+    std::sort(children.begin(), children.end(), [](const ProcInfo* a, const ProcInfo* b) { return a->pid > b->pid; });
+
+    int w = r.pidWidth();
+    append_row(out, "%*s %*s COMMAND\n", w, "PID", w, "PPID");
+    for (const ProcInfo* p : children) {
+        append_row(out, "%*d %*d ", w, p->pid, w, p->ppid);
+        out += p->comm + "\n";
+    }
+    return true;
+}
+
+// echo header; ps -o pid,ppid,state,cmd --forest -p PID --ppid PID --sort pid
+static bool osproctree(const ProcReader& r, const ProcSnapshot& snap, int pid, std::string& out) {
+    bool exists = false;
+    long root = live_index(r, snap, pid, exists);
+    if (!exists) {
+        out += "PID " + std::to_string(pid) + " does not exist.\n";
+        return true;
+    }
+    if (root < 0) return false; // started after the scan; the script reads it live
+    out += "process Tree starting from PID: " + std::to_string(pid) + "\n";
+
+    std::vector<const ProcInfo*> children = children_of(snap, pid);
+    std::sort(children.begin(), children.end(), [](const ProcInfo* a, const ProcInfo* b) { return a->pid < b->pid; });
+
+    int w = r.pidWidth();
+    const ProcInfo& rp = snap.procs[root];
+    append_row(out, "%*s %*s S CMD\n", w, "PID", w, "PPID");
+    append_row(out, "%*d %*d %c ", w, rp.pid, w, rp.ppid, rp.state);
+    out += fmt_cmd(rp) + "\n";
+    for (const ProcInfo* p : children) {
+        append_row(out, "%*d %*d %c ", w, p->pid, w, p->ppid, p->state);
+        // ps --forest draws children of init as top-level entries
+        out += (pid == 1 ? "" : " \\_ ") + fmt_cmd(*p) + "\n";
+    }
+    return true;
+}
+
+static AuditStore& audit_store() {
+    static AuditStore instance;
+    return instance;
+}
+
+bool run(const std::string& tool, const std::vector<std::string>& args, std::string& output) {
+    if (tool == "osaudit_query") {
+        // Bad arguments are reported here; the script would only repeat them
+        AuditQuery query;
+        std::string error;
+        output = query.parse(args, error) ? audit_store().run(query) : error + "\n";
+        return true;
+    }
+
+    const ProcReader& r = reader();
+    if (!r.ok()) return false;
+
+    std::string out;
+    int pid = 0;
+    bool handled = false;
+    if (tool == "osps" || tool == "osuptime_plus") {
+        if (!args.empty()) return false;
+        auto snap = snapshots().get();
+        handled = (tool == "osps") ? osps(r, *snap, out) : osuptime_plus(r, *snap, out);
+    } else if (tool == "process_info" || tool == "process_state" ||
+               tool == "osproc_children_list" || tool == "osproctree") {
+        // Usage errors and non-numeric PIDs keep the script's own messages
+        if (args.size() != 1 || !parse_pid(args[0], pid)) return false;
+        if (tool == "process_info") handled = process_info(r, pid, out);
+        else if (tool == "process_state") handled = process_state(r, pid, out);
+        else if (tool == "osproc_children_list") handled = osproc_children_list(r, *snapshots().get(), pid, out);
+        else handled = osproctree(r, *snapshots().get(), pid, out);
+    }
+    if (handled) output = std::move(out);
+    return handled;
+}
+
+} // namespace native_tools
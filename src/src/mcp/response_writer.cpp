@@ -0,0 +1,78 @@
+#include "mcp/response_writer.hpp"
+#include "utils/logger.hpp"
+#include <cerrno>
+#include <climits>
+#include <algorithm>
+#include <sys/uio.h>
+
+ResponseWriter::ResponseWriter(int fd) : fd(fd), thread(&ResponseWriter::writer_loop, this) {}
+
+ResponseWriter::~ResponseWriter() {
+    shutdown();
+}
+
+void ResponseWriter::send(std::string message) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(std::move(message));
+    }
+    cv.notify_one();
+}
+
+void ResponseWriter::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_one();
+    if (thread.joinable()) thread.join();
+}
+
+void ResponseWriter::writer_loop() {
+    std::vector<std::string> batch;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cv.wait(lock, [&] { return stopping || !pending.empty(); });
+        if (pending.empty()) return; // stopping and drained
+
+        batch.swap(pending);
+        lock.unlock();
+        write_batch(batch);
+        batch.clear();
+        lock.lock();
+    }
+}
+
+void ResponseWriter::write_batch(const std::vector<std::string>& batch) {
+    static const char newline = '\n';
+
+    std::vector<struct iovec> iov;
+    iov.reserve(batch.size() * 2);
+    for (const auto& msg : batch) {
+        iov.push_back({const_cast<char*>(msg.data()), msg.size()});
+        iov.push_back({const_cast<char*>(&newline), 1});
+    }
+
+    // writev may write partially and takes at most IOV_MAX entries per call
+    size_t first = 0;
+    while (first < iov.size()) {
+        int count = (int)std::min(iov.size() - first, (size_t)IOV_MAX);
+        ssize_t n = writev(fd, &iov[first], count);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            utils::Logger::error("ResponseWriter: writev failed, dropping " +
+                                 std::to_string(batch.size()) + " messages");
+            return;
+        }
+        while (n > 0 && first < iov.size()) {
+            if ((size_t)n >= iov[first].iov_len) {
+                n -= iov[first].iov_len;
+                first++;
+            } else {
+                iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + n;
+                iov[first].iov_len -= n;
+                n = 0;
+            }
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#include "mcp/result_cache.hpp"
+#include "utils/json.hpp"
+#include <cstdio>
+#include <iterator>
+
+ResultCache::ResultCache(size_t max_bytes) : max_bytes(max_bytes) {}
+
+std::string ResultCache::make_key(const std::string& tool, const std::vector<std::string>& args) {
+    // Unit separators cannot appear in tool names and keep "a b" distinct from "a","b"
+    std::string key = tool;
+    for (const auto& a : args) {
+        key += '\x1f';
+        key += a;
+    }
+    return key;
+}
+
+void ResultCache::erase(std::list<Entry>::iterator it) {
+    bytes -= cost(*it);
+    index.erase(it->key);
+    lru.erase(it);
+}
+
+bool ResultCache::get(const std::string& tool, const std::vector<std::string>& args, std::string& result) {
+    std::string key = make_key(tool, args);
+    std::lock_guard<std::mutex> lock(mutex);
+    Counters& counters = per_tool[tool];
+
+    auto it = index.find(key);
+    if (it != index.end() && std::chrono::steady_clock::now() >= it->second->expires) {
+        erase(it->second);
+        it = index.end();
+    }
+    if (it == index.end()) {
+        total.misses++;
+        counters.misses++;
+        return false;
+    }
+
+    lru.splice(lru.begin(), lru, it->second);
+    result = it->second->value;
+    total.hits++;
+    counters.hits++;
+    return true;
+}
+
+void ResultCache::put(const std::string& tool, const std::vector<std::string>& args,
+                      const std::string& result, int ttl_ms) {
+    if (max_bytes == 0 || ttl_ms <= 0) return;
+    Entry entry{make_key(tool, args), result,
+                std::chrono::steady_clock::now() + std::chrono::milliseconds(ttl_ms)};
+    if (cost(entry) > max_bytes / 4) return; // one huge result should not flush everything
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto existing = index.find(entry.key);
+    if (existing != index.end()) erase(existing->second);
+
+    bytes += cost(entry);
+    lru.push_front(std::move(entry));
+    index[lru.front().key] = lru.begin();
+
+    while (bytes > max_bytes && !lru.empty()) {
+        erase(std::prev(lru.end()));
+        evictions++;
+    }
+}
+
+std::string ResultCache::statsJson() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto rate = [](const Counters& c) {
+        char buf[16];
+        uint64_t lookups = c.hits + c.misses;
+        snprintf(buf, sizeof(buf), "%.3f", lookups ? (double)c.hits / lookups : 0.0);
+        return std::string(buf);
+    };
+
+    std::string tools;
+    for (const auto& t : per_tool) {
+        if (!tools.empty()) tools += ",";
+        tools += json::str(t.first) + ":{\"hits\":" + std::to_string(t.second.hits) +
+                 ",\"misses\":" + std::to_string(t.second.misses) +
+                 ",\"hit_rate\":" + rate(t.second) + "}";
+    }
+    return "{\"hits\":" + std::to_string(total.hits) +
+           ",\"misses\":" + std::to_string(total.misses) +
+           ",\"hit_rate\":" + rate(total) +
+           ",\"entries\":" + std::to_string(lru.size()) +
+           ",\"bytes\":" + std::to_string(bytes) +
+           ",\"max_bytes\":" + std::to_string(max_bytes) +
+           ",\"evictions\":" + std::to_string(evictions) +
+           ",\"tools\":{" + tools + "}}";
+}
@@ -1,3 +1,15 @@
+#include "mcp/tool_exec.hpp"
+#include "mcp/tool_registry.hpp"
+#include "mcp/native_tools.hpp"
+#include "mcp/result_cache.hpp"
+#include "mcp/tool_stats.hpp"
+#include "mcp/zygote_pool.hpp"
+#include "mcp/tool_cgroups.hpp"
+#include "mcp/shell_session.hpp"
+#include "mcp/worker_pool.hpp"
+#include "mcp/response_writer.hpp"
+#include "dispatch_policy.h"
+#include "audit_log.h"
 #include "utils/json.hpp"
 #include "utils/jsonrpc.hpp"
 #include "utils/logger.hpp"
@@ -5,81 +17,161 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <algorithm>
 #include <memory>
-#include <array>
+#include <mutex>
+#include <chrono>
+#include <cerrno>
+#include <climits>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
 class MCPServerApp {
 public:
-    MCPServerApp() : tools_directory("/usr/local/share/ollmcpc/tools") {
-        // Tools are installed globally to /usr/local/share/ollmcpc/tools
-        // This allows running ollmcpc from any directory
+    MCPServerApp(size_t workers, const std::string& tools_dir, size_t cache_bytes,
+                 size_t zygote_workers, int worker_jobs)
+        : tools_directory(tools_dir), dispatcher_path(find_dispatcher(tools_dir)),
+          registry(tools_dir + "/manifest.json"),
+          cache(cache_bytes), zygote(dispatcher_path, zygote_workers, worker_jobs),
+          pool(workers), writer(STDOUT_FILENO) {
+        // Tool scripts that call the dispatcher (osaudit_query.sh) find it here
+        setenv("OLLMCPC_DISPATCHER", dispatcher_path.c_str(), 1);
+        registry.load();
+        apply_limits();
+        native_tools::prime();
+        use_zygote = zygote_workers > 0;
+    }
+
+    // Run every script in a transient cgroup under root ("" = our own cgroup).
+    // Must come before run(), so the zygote starts outside the tool cgroups.
+    void enableCgroups(const std::string& root) {
+        cgroups.init(root);
+    }
+
+    // Keep one bash session for "run": "command" tools, so cwd and
+    // environment carry over between calls (see shell_session.hpp)
+    void enableShellSession() {
+        shell = std::make_unique<ShellSession>(dispatcher_path, cgroups);
     }
  
+    // Per-tool concurrency cap, e.g. keep heavy scanners to one at a time.
+    // Set from the command line; takes precedence over the manifest.
+    void setToolLimit(const std::string& tool, int max_concurrent) {
+        cli_limits[tool] = max_concurrent;
+        pool.setLimit(tool, max_concurrent);
+    }
 
+    // The main thread only reads and dispatches. tools/call requests run on
+    // the worker pool and their responses are written as each one completes
+    // (possibly out of order, matched by id on the client side).
     void run() {
+        if (use_zygote) use_zygote = zygote.start();
+        // Policy decisions made in-process are group-committed to the audit log
+        audit_start_writer();
+        utils::Logger::debug("mcp_server started with " + std::to_string(pool.size()) + " workers");
         std::string line;
         while (std::getline(std::cin, line)) {
             if (line.empty()) continue;
             process_request(line);
         }
+        pool.shutdown();
+        if (shell) shell->stop();
+        audit_flush();
+        writer.shutdown();
+        utils::Logger::debug("mcp_server stats: " + stats_json());
     }
 
 private:
     std::string tools_directory;
+    std::string dispatcher_path;
+    ToolRegistry registry;
+    ResultCache cache;
+    ToolStats tool_stats;
+    ZygotePool zygote;
+    bool use_zygote = false;
+    ToolCgroups cgroups;
+    std::unique_ptr<ShellSession> shell;
+    std::map<std::string, int> cli_limits;
+    WorkerPool pool;
+    ResponseWriter writer;
 
-    struct ToolMeta {
-        std::string name;
-        std::string script;
-        std::string description;
-        std::string inputSchema;
-    };
-    
-    // Hardcoded tool definitions
-    std::vector<ToolMeta> tools_metadata = {
-        // {"osassist_battery_info", "osassist_battery_info.sh", "Show battery and memory info", R"({"type":"object","properties":{}})"},
-        // {"osassist_memory_info", "osassist_memory_info.sh", "Show memory and battery info", R"({"type":"object","properties":{}})"},
-        // {"osecho_plus", "osecho_plus.sh", "Print a message with optional level and timestamp", R"({"type":"object","properties":{"message":{"type":"string"},"level":{"type":"string"},"ts":{"type":"boolean"},"log":{"type":"string"}}})"},
-        // {"osenv_guard", "osenv_guard.sh", "Show environment variables with redacted secrets", R"({"type":"object","properties":{}})"},
-        // {"oswhoami", "oswhoami.sh", "Show current user and environment info", R"({"type":"object","properties":{}})"},
-        // {"osps", "osps.sh", "List processes sorted by CPU usage", R"({"type":"object","properties":{}})"},
-        // {"osproctree", "osproctree.sh", "Show a process tree for a PID", R"({"type":"object","properties":{"pid":{"type":"integer"}}})"},
-        // {"oskillsafe", "oskillsafe.sh", "Safely terminate a process by PID", R"({"type":"object","properties":{"pid":{"type":"integer"}},"required":["pid"]})"},
-        // {"osstop", "osstop.sh", "Stop a process by PID", R"({"type":"object","properties":{"pid":{"type":"integer"}},"required":["pid"]})"},
-        // {"oscont", "oscont.sh", "Resume a stopped process by PID", R"({"type":"object","properties":{"pid":{"type":"integer"}},"required":["pid"]})"},
-        // {"osspawnchildren", "osspawnchildren.sh", "Spawn child processes for demo", R"({"type":"object","properties":{"number":{"type":"integer"},"command":{"type":"string"},"nowait":{"type":"boolean"}}})"},
-        // {"osorphan", "osorphan.sh", "Run orphan process demo", R"({"type":"object","properties":{}})"},
-        // {"oszombie", "oszombie.sh", "Run zombie process demo", R"({"type":"object","properties":{}})"},
-        // {"ostreedemo", "ostreedemo.sh", "Run fork tree demo", R"({"type":"object","properties":{}})"},
-        // {"oshelp", "oshelp.sh", "Show Mini-OS help and demos", R"({"type":"object","properties":{"command":{"type":"string"},"arg":{"type":"string"}}})"},
-        // {"osdiskfree", "osdiskfree.sh", "Show disk usage for a path", R"({"type":"object","properties":{"path":{"type":"string"}},"required":["path"]})"},
-        // {"osdir_size_top", "osdir_size_top.sh", "Show largest items in a directory", R"({"type":"object","properties":{}})"},
-        // {"osmem_heapstack_range", "osmem_heapstack_range.sh", "Show heap and stack ranges for a PID", R"({"type":"object","properties":{"pid":{"type":"integer"}},"required":["pid"]})"},
-        // {"osmem_usage", "osmem_usage.sh", "Show memory summary and status", R"({"type":"object","properties":{}})"},
-        // {"osnet_basic", "osnet_basic.sh", "Show basic network status", R"({"type":"object","properties":{}})"},
-        // {"osproc_children_list", "osproc_children_list.sh", "Show child processes as a tree", R"({"type":"object","properties":{"pid":{"type":"integer"}},"required":["pid"]})"},
-        // {"osproc_find", "osproc_find.sh", "Find processes by name pattern", R"({"type":"object","properties":{"pattern":{"type":"string"}},"required":["pattern"]})"},
-        {"osproc_openfiles", "osproc_openfiles.sh", "Show open files for a process", R"({"type":"object","properties":{"pid":{"type":"integer"}},"required":["pid"]})"},
-        {"osshm_list", "osshm_list.sh", "List shared memory segments", R"({"type":"object","properties":{}})"},
-        {"ossig_pingpong", "ossig_pingpong.sh", "Run the signal ping-pong demo", R"({"type":"object","properties":{"rounds":{"type":"integer"}}})"},
-        {"osthread_demo", "osthread_demo.sh", "Run the thread roles demo", R"({"type":"object","properties":{}})"},
-        {"osthread_sync_demo", "osthread_sync_demo.sh", "Run the thread sync demo", R"({"type":"object","properties":{}})"},
-        {"osuptime_plus", "osuptime_plus.sh", "Show uptime, load average, and top processes", R"({"type":"object","properties":{}})"},
-        {"process_info", "process_info.sh", "Show detailed process info", R"({"type":"object","properties":{"pid":{"type":"integer"}},"required":["pid"]})"},
-        {"process_state", "process_state.sh", "Show process state", R"({"type":"object","properties":{"pid":{"type":"integer"}},"required":["pid"]})"},
-        {"run_shell_command", "run_shell_command.sh", "Run a shell command", R"({"type":"object","properties":{"command":{"type":"string"}},"required":["command"]})"}
-        
-    };
+    // Requests queued or running on the pool, for notifications/cancelled
+    std::mutex inflight_mutex;
+    std::map<int, std::shared_ptr<CancelToken>> inflight;
+
+    // Reply to server/stats (an ollmcpc extension, shown by /stats)
+    std::string stats_json() const {
+        return "{\"cache\":" + cache.statsJson() +
+               ",\"execution\":" + tool_stats.statsJson() +
+               ",\"zygote\":" + zygote.statsJson() +
+               ",\"cgroups\":" + cgroups.statusJson() +
+               ",\"shell_session\":" + (shell ? shell->statsJson() : "null") +
+               ",\"audit\":" + audit_stats_json() + "}";
+    }
 
+    static std::string audit_stats_json() {
+        uint64_t records = 0, batches = 0, rotations = 0;
+        audit_counters(&records, &batches, &rotations);
+        return "{\"records\":" + std::to_string(records) + ",\"batches\":" + std::to_string(batches) +
+               ",\"rotations\":" + std::to_string(rotations) + "}";
+    }
+
+    // The dispatcher installed with the tools, else the one the build put
+    // next to mcp_server (running from the build directory)
+    static std::string find_dispatcher(const std::string& tools_dir) {
+        std::string installed = tools_dir + "/dispatcher";
+        if (access(installed.c_str(), X_OK) == 0) return installed;
+        char self[4096];
+        ssize_t n = readlink("/proc/self/exe", self, sizeof(self) - 1);
+        if (n <= 0) return installed;
+        std::string built(self, (size_t)n);
+        built = built.substr(0, built.rfind('/') + 1) + "dispatcher";
+        return access(built.c_str(), X_OK) == 0 ? built : installed;
+    }
+
+    void apply_limits() {
+        for (const auto& tool : registry.all()) {
+            if (!cli_limits.count(tool->name)) pool.setLimit(tool->name, tool->max_concurrent);
+        }
+    }
+
+    void handle_cancel(const std::string& params) {
+        std::string id_str = json_parse::extract_val(params, "\"requestId\":");
+        if (id_str.empty()) return;
+        utils::Logger::debug("Cancellation received for request " + id_str + ": " +
+                             json::parse::get_string(params, "reason"));
+
+        // Ids are ints here; anything else (string ids, overflow) cannot be ours
+        char* end = nullptr;
+        errno = 0;
+        long long id = std::strtoll(id_str.c_str(), &end, 10);
+        if (end == id_str.c_str() || *end != '\0' || errno == ERANGE || id < INT_MIN || id > INT_MAX) {
+            utils::Logger::debug("Cancellation ignored: request id " + id_str + " is not one of ours");
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(inflight_mutex);
+        auto it = inflight.find((int)id);
+        if (it != inflight.end()) it->second->cancel();
+    }
 
     void process_request(const std::string& json_req) {
         utils::Logger::debug("Server received: " + json_req);
         // Parse JSON-RPC request
         auto req = jsonrpc::parse_request(json_req);
         
+        // Pick up manifest edits without a restart
+        if (registry.reloadIfChanged()) {
+            apply_limits();
+            writer.send(R"({"jsonrpc":"2.0","method":"notifications/tools/list_changed"})");
+        }
+        
         if (req.is_notification) {
-            utils::Logger::debug("Request ignored (notification)");
+            if (req.method == "notifications/cancelled") handle_cancel(req.params);
+            else utils::Logger::debug("Request ignored (notification)");
             return; 
         }
         
@@ -89,219 +181,269 @@ private:
             result = R"({
                 "protocolVersion": "2024-11-05",
                 "serverInfo": {"name": "c-mcp-server", "version": "1.2"},
-                "capabilities": {"tools": {}}
+                "capabilities": {"tools": {"listChanged": true}}
             })";
         } else if (req.method == "tools/list") {
-            result = "{\"tools\": [";
-            for (size_t i = 0; i < tools_metadata.size(); ++i) {
-                if (i > 0) result += ",";
-                result += "{\"name\":" + json::str(tools_metadata[i].name) + 
-                          ",\"description\":" + json::str(tools_metadata[i].description) + 
-                          ",\"inputSchema\":" + tools_metadata[i].inputSchema + "}";
-            }
-            result += "]}";
+            result = registry.toolsListResult();
+        } else if (req.method == "server/stats") {
+            result = stats_json();
         } else if (req.method == "tools/call") {
+            auto token = std::make_shared<CancelToken>();
+            {
+                std::lock_guard<std::mutex> lock(inflight_mutex);
+                inflight[req.id] = token;
+            }
+            std::string name = json::parse::get_string(req.params, "name");
+            auto queued = std::chrono::steady_clock::now();
+            pool.submit(name, [this, req, token, queued] { call_tool(req, *token, queued); });
+            return;
+        }
+        
+        // Send JSON-RPC response
+        writer.send(jsonrpc::response(req.id, result));
+    }
+
+    // What execute_tool learned about a run besides its output
+    struct RunInfo {
+        tool_exec::Outcome outcome = tool_exec::Outcome::Completed;
+        ResourceUsage usage;     // valid only for runs in a cgroup
+        std::string progress_token;   // raw JSON from params._meta, "" = no streaming
+        size_t progress_frames = 0;   // notifications/progress sent
+        bool refused = false;         // the policy refused the command, or part of it
+    };
+
+    // Bytes of output a streamed run repeats in its final response
+    static constexpr size_t STREAM_TAIL_BYTES = 2048;
+
+    // Runs on a worker thread
+    void call_tool(const jsonrpc::Request& req, const CancelToken& cancel,
+                   std::chrono::steady_clock::time_point queued) {
+        auto started = std::chrono::steady_clock::now();
+        std::string result;
+        if (!cancel.cancelled()) {
              std::string name = json::parse::get_string(req.params, "name");
              std::string exec_dangerous = json::parse::get_string(req.params, "exec_dangerous");
              std::string args_json = json::parse::get_object(req.params, "arguments");
              
              utils::Logger::debug("Lookup tool: [" + name + "] exec_dangerous=" + exec_dangerous);
              
-             // Find tool
-             auto it = std::find_if(tools_metadata.begin(), tools_metadata.end(), 
-                                   [&](const ToolMeta& t){ return t.name == name; });
-             
-             if (it != tools_metadata.end()) {
-                 utils::Logger::debug("Executing " + it->name);
+             auto tool = registry.find(name);
+             if (tool) {
+                 utils::Logger::debug("Executing " + tool->name);
                  
-                 std::string output = execute_tool(it->script, args_json, it->name,exec_dangerous);
-                 result = "{\"content\":[{\"type\":\"text\",\"text\":" + json::str(output) + "}]}";
+                 RunInfo info;
+                 for (const auto& m : json::parse::members(json::parse::get_object(req.params, "_meta"))) {
+                     if (m.first == "progressToken") info.progress_token = m.second;
+                 }
+                 std::string output = execute_tool(*tool, args_json, exec_dangerous, cancel, info);
+                 auto finished = std::chrono::steady_clock::now();
+                 tool_stats.record(tool->name,
+                                   std::chrono::duration<double, std::milli>(started - queued).count(),
+                                   std::chrono::duration<double, std::milli>(finished - started).count(),
+                                   info.outcome);
+                 tool_stats.recordUsage(tool->name, info.usage);
+                 result = tool_result(*tool, output, info);
              } else {
                  utils::Logger::error("Tool not found: [" + name + "]");
                  result = "{\"isError\":true,\"content\":[{\"type\":\"text\",\"text\":\"Unknown tool\"}]}";
              }
         }
-        
-        // Send JSON-RPC response
-        std::cout << jsonrpc::response(req.id, result) << std::endl;
+
+        {
+            std::lock_guard<std::mutex> lock(inflight_mutex);
+            inflight.erase(req.id);
+        }
+
+        // A cancelled request gets no response; the client has moved on
+        if (cancel.cancelled()) {
+            utils::Logger::debug("Request " + std::to_string(req.id) + " cancelled, response dropped");
+            return;
+        }
+        writer.send(jsonrpc::response(req.id, result));
+    }
+
+    // A run stopped by a limit keeps its partial output, followed by a note the
+    // model can read, and says what happened in structuredContent. A run in a
+    // cgroup reports its cost in _meta.resources. A streamed run already
+    // delivered its output, so the response repeats only a summary and the tail.
+    static std::string tool_result(const ToolMeta& tool, std::string output, const RunInfo& info) {
+        if (info.progress_frames > 0) {
+            size_t total = output.size();
+            if (total > STREAM_TAIL_BYTES) {
+                output.erase(0, total - STREAM_TAIL_BYTES);
+                size_t nl = output.find('\n');
+                if (nl != std::string::npos && nl + 1 < output.size()) output.erase(0, nl + 1);
+            }
+            output = "[" + tool.name + " streamed " + std::to_string(total) + " bytes in " +
+                     std::to_string(info.progress_frames) + " progress notifications; last " +
+                     std::to_string(output.size()) + " bytes follow]\n" + output;
+        }
+        std::string meta = info.usage.valid ? ",\"_meta\":{\"resources\":" + info.usage.json() + "}" : "";
+        std::string error, note;
+        if (info.outcome == tool_exec::Outcome::TimedOut) {
+            error = "{\"error\":\"timeout\",\"limit_ms\":" + std::to_string(tool.timeout_ms);
+            note = "[Error: " + tool.name + " timed out after " + std::to_string(tool.timeout_ms) +
+                   " ms; the output above is partial]";
+        } else if (info.outcome == tool_exec::Outcome::OutputLimit) {
+            error = "{\"error\":\"output_limit\",\"limit_bytes\":" + std::to_string(tool.max_output_bytes);
+            note = "[Error: " + tool.name + " exceeded its " + std::to_string(tool.max_output_bytes) +
+                   " byte output limit and was stopped; the output above is truncated]";
+        } else if (info.refused) {
+            error = "{\"error\":\"refused\"";
+            note = "[Error: " + tool.name + " was refused by the command policy; see the message above]";
+        } else {
+            return "{\"content\":[{\"type\":\"text\",\"text\":" + json::str(output) + "}]" + meta + "}";
+        }
+        error += ",\"partial_bytes\":" + std::to_string(output.size()) + "}";
+        if (!output.empty() && output.back() != '\n') output += '\n';
+        return "{\"isError\":true,\"content\":[{\"type\":\"text\",\"text\":" + json::str(output + note) +
+               "}],\"structuredContent\":" + error + meta + "}";
     }
 
-    std::string execute_tool(const std::string& script, const std::string& args_json, const std::string& tool_name, std::string exec_dangerous) {
-        utils::Logger::debug("execute_tool: " + tool_name + " exec_dangerous=" + exec_dangerous);
-        std::string cmd = tools_directory + "/dispatcher " + ((exec_dangerous == "YES") ? "-y" : "-n") + " ";
+    std::string execute_tool(const ToolMeta& tool, const std::string& args_json,
+                             std::string exec_dangerous, const CancelToken& cancel,
+                             RunInfo& info) {
+        utils::Logger::debug("execute_tool: " + tool.name + " exec_dangerous=" + exec_dangerous);
         std::vector<std::string> args;
-        
-        // Basic argument parsing leveraging json helper logic or manual (since logic was in ToolRunner)
-        // We will inline the specific logic for minimal dependencies
-        
-        if (tool_name == "process_info" ||
-                   tool_name == "process_state" ||
-                   tool_name == "osproc_children_list" ||
-                   tool_name == "osproc_openfiles" ||
-                   tool_name == "osmem_heapstack_range" ||
-                   tool_name == "osstop" ||
-                   tool_name == "oscont" ||
-                   tool_name == "oskillsafe") {
-             std::string pid = json_parse::extract_string(args_json, "pid");
-             if (pid.empty()) {
-                 pid = json_parse::extract_string(args_json, "value");
-             }
-             if (pid.empty()) {
-                 pid = json_parse::extract_val(args_json, "\"pid\":");
-             }
-             if (pid.empty() && tool_name == "osproc_openfiles") {
-                 pid = json_parse::extract_string(args_json, "path");
-             }
-             if (!pid.empty()) args.push_back(pid);
-        } else if (tool_name == "osproc_find") {
-             std::string pattern = json_parse::extract_string(args_json, "pattern");
-             if (pattern.empty()) {
-                 pattern = json_parse::extract_string(args_json, "value");
-             }
-             if (!pattern.empty()) args.push_back(pattern);
-        } else if (tool_name == "osfile_watch") {
-             std::string path = json_parse::extract_string(args_json, "path");
-             std::string interval = json_parse::extract_string(args_json, "interval");
-             std::string lines = json_parse::extract_string(args_json, "lines");
-             if (path.empty()) return "Error: osfile_watch requires a path";
-             if (!path.empty()) args.push_back(path);
-             if (!interval.empty()) {
-                 args.push_back("--interval");
-                 args.push_back(interval);
-             }
-             if (!lines.empty()) {
-                 args.push_back("--lines");
-                 args.push_back(lines);
-             }
-        } else if (tool_name == "ossig_pingpong") {
-             std::string rounds = json_parse::extract_string(args_json, "rounds");
-             if (rounds.empty()) {
-                 rounds = json_parse::extract_string(args_json, "value");
-             }
-             if (!rounds.empty()) args.push_back(rounds);
-        } else if (tool_name == "osproctree") {
-             std::string pid = json_parse::extract_string(args_json, "pid");
-             if (pid.empty()) {
-                 pid = json_parse::extract_string(args_json, "value");
-             }
-             if (pid.empty()) {
-                 pid = json_parse::extract_val(args_json, "\"pid\":");
-             }
-             if (!pid.empty()) args.push_back(pid);
-        } else if (tool_name == "osspawnchildren") {
-             std::string count = json_parse::extract_string(args_json, "number");
-             std::string command = json_parse::extract_string(args_json, "command");
-             std::string nowait = json_parse::extract_string(args_json, "nowait");
-             if (count.empty()) {
-                 count = json_parse::extract_string(args_json, "value");
-             }
-             if (count.empty()) {
-                 count = json_parse::extract_val(args_json, "\"number\":");
-             }
-             if (nowait.empty()) {
-                 nowait = json_parse::extract_val(args_json, "\"nowait\":");
-             }
-             if (!count.empty()) {
-                 args.push_back("--number");
-                 args.push_back(count);
-             }
-             if (!command.empty()) {
-                 args.push_back("--command");
-                 args.push_back(command);
-             }
-             if (nowait == "true" || nowait == "1") {
-                 args.push_back("--nowait");
-             }
-        } else if (tool_name == "oshelp") {
-             std::string command = json_parse::extract_string(args_json, "command");
-             std::string arg = json_parse::extract_string(args_json, "arg");
-             if (command.empty()) {
-                 command = json_parse::extract_string(args_json, "value");
-             }
-             if (!command.empty()) args.push_back(command);
-             if (!arg.empty()) args.push_back(arg);
-        } else if (tool_name == "osdiskfree") {
-             std::string path = json_parse::extract_string(args_json, "path");
-             if (path.empty()) {
-                 path = json_parse::extract_string(args_json, "value");
-             }
-             if (!path.empty()) args.push_back(path);
-        } else if (tool_name == "osecho_plus") {
-             std::string level = json_parse::extract_string(args_json, "level");
-             std::string log = json_parse::extract_string(args_json, "log");
-             std::string message = json_parse::extract_string(args_json, "message");
-             if (message.empty()) {
-                 message = json_parse::extract_string(args_json, "value");
-             }
-             std::string ts_str = json_parse::extract_string(args_json, "ts");
-             bool with_ts = false;
-             if (ts_str == "true" || ts_str == "1") with_ts = true;
-             if (!level.empty()) {
-                 args.push_back("--level");
-                 args.push_back(level);
-             }
-             if (with_ts) {
-                 args.push_back("--ts");
-             }
-             if (!log.empty()) {
-                 args.push_back("--log");
-                 args.push_back(log);
-             }
-             if (!message.empty()) args.push_back(message);
-        } else if (tool_name == "run_shell_command") {
-             std::string c = json_parse::extract_string(args_json, "command");
-             if (!c.empty()) args.push_back(c);
-        } else if (tool_name == "run_secure_shell_command") {
-             std::string c = json_parse::extract_string(args_json, "command");
-             if (!c.empty()) args.push_back(c);
+        std::string error;
+        if (!tool.binder.bind(args_json, args, error)) return error;
+
+        // Read-only results are reused for cache_ttl_ms
+        bool cacheable = tool.cacheable() && cache.enabled();
+        std::string cached;
+        if (cacheable && cache.get(tool.name, args, cached)) {
+            utils::Logger::debug("[execute_tool] " + tool.name + " served from cache");
+            return cached;
+        }
+
+        std::string result;
+        if (tool.native && native_tools::run(tool.name, args, result)) {
+            // Same audit entry and trailer the dispatcher gives the script
+            policy_audit((tools_directory + "/" + tool.script).c_str(), "ALLOWED", "Passing to execution engine");
+            result += "External Command executed successfully";
+            utils::Logger::debug("[execute_tool] " + tool.name + " served natively, " +
+                                 std::to_string(result.length()) + " bytes");
+            if (cacheable) cache.put(tool.name, args, result, tool.cache_ttl_ms);
+            return result;
+        }
+
+        // Long-running tools forward each read as it arrives when the client
+        // asked for progress (params._meta.progressToken)
+        tool_exec::OutputSink sink;
+        size_t streamed = 0;
+        if (tool.stream && !info.progress_token.empty()) {
+            sink = [this, &info, &streamed](const char* data, size_t len) {
+                streamed += len;
+                info.progress_frames++;
+                writer.send("{\"jsonrpc\":\"2.0\",\"method\":\"notifications/progress\",\"params\":{"
+                            "\"progressToken\":" + info.progress_token +
+                            ",\"progress\":" + std::to_string(streamed) +
+                            ",\"message\":" + json::str(std::string(data, len)) + "}}");
+            };
         }
 
-        // Construct command line
-        std::string script_path = tools_directory + "/" + script;
-        if (tool_name == "run_shell_command" || tool_name == "run_secure_shell_command") {
-             cmd += script_path;
+        // With --shell-session, commands go to the persistent shell instead
+        if (shell && tool.run == "command") {
+            std::string command;
+            for (const auto& arg : args) command += (command.empty() ? "" : " ") + arg;
+            utils::Logger::debug("[execute_tool] Shell session command: " + command);
+            // Not a verdict yet: the session's DEBUG trap checks each command as it runs
+            policy_audit(command.c_str(), "SUBMITTED", "Passing to shell session");
+            int status = -1;
+            if (shell->run(tool, command, exec_dangerous == "YES", result, &cancel, &info.outcome, &status,
+                           &info.refused, sink)) {
+                // Same trailer as the dispatcher, with the status if it failed;
+                // a refusal already printed the dispatcher's message
+                if (info.outcome == tool_exec::Outcome::Completed && !(info.refused && status == 0)) {
+                    std::string trailer = (result.empty() || result.back() == '\n') ? "" : "\n";
+                    trailer += status == 0 ? "External Command executed successfully"
+                             : status > 0 ? "Command exited with status " + std::to_string(status)
+                             : "Shell session ended";
+                    result += trailer;
+                    if (sink) sink(trailer.data(), trailer.size());
+                }
+                if (!result.empty() && result.back() == '\n') result.pop_back();
+                return result;
+            }
+            utils::Logger::error("[execute_tool] shell session unavailable, running " + tool.name + " directly");
+        }
+
+        // program args... Every argument stays a separate element end to
+        // end; nothing is quoted here or re-split later.
+        std::vector<std::string> program;
+        if (tool.run == "command") {
              for (const auto& arg : args) {
-                 std::string escaped = arg;
-                 size_t pos = 0;
-                 while ((pos = escaped.find("\"", pos)) != std::string::npos) {
-                     escaped.replace(pos, 1, "\\\"");
-                     pos += 2;
-                 }
-                 cmd += " \"" + escaped + "\"";
+                 for (const auto& word : tool_exec::split_command_words(arg)) program.push_back(word);
              }
+             if (program.empty()) return "Error: " + tool.name + " requires a command";
         } else {
-             std::string packed = script_path;
-             for (const auto& arg : args) {
-                 packed += " ";
-                 packed += arg;
-             }
-             std::string escaped = packed;
-             size_t pos = 0;
-             while ((pos = escaped.find("\"", pos)) != std::string::npos) {
-                 escaped.replace(pos, 1, "\\\"");
-                 pos += 2;
-             }
-             cmd += "\"" + escaped + "\"";
+             program.push_back(tools_directory + "/" + tool.script);
+             for (const auto& arg : args) program.push_back(arg);
         }
+
+        // The dispatcher's policy is decided here, in-process, and only the
+        // program itself is exec'd. Internal commands (sched, wipe) still go
+        // through the dispatcher, which implements them and checks again.
+        CommandMetadata policy;
+        PolicyVerdict verdict = policy_check(program[0].c_str(), exec_dangerous == "YES", &policy);
+        if (verdict != POLICY_ALLOWED) {
+            char refusal[512];
+            result = policy_refusal(verdict, program[0].c_str(), refusal, sizeof(refusal));
+            if (!result.empty() && result.back() == '\n') result.pop_back();
+            info.refused = true;
+            return result;
+        }
+        bool direct = !policy.is_internal;
+        if (direct) policy_audit(program[0].c_str(), "ALLOWED", "Passing to execution engine");
+
+        // Spawned argv: the program alone, or with a cgroup
+        //   dispatcher --cgroup DIR --exec program args...
+        // and for internal commands
+        //   dispatcher [--cgroup DIR] -y|-n program args...
+        std::string cgroup = cgroups.create(tool.name, tool.cgroup);
+        std::vector<std::string> argv;
+        if (!direct || !cgroup.empty()) {
+            argv.push_back(dispatcher_path);
+            if (!cgroup.empty()) {
+                argv.push_back("--cgroup");
+                argv.push_back(cgroup);
+            }
+            argv.push_back(!direct ? ((exec_dangerous == "YES") ? "-y" : "-n") : "--exec");
+        }
+        argv.insert(argv.end(), program.begin(), program.end());
+        std::string cmd;
+        for (const auto& a : argv) cmd += (cmd.empty() ? "" : " ") + a;
         
         // Log the command being executed
-        utils::Logger::debug("[execute_tool] Tool: " + tool_name);
-        utils::Logger::debug("[execute_tool] Script: " + script);
+        utils::Logger::debug("[execute_tool] Tool: " + tool.name);
+        utils::Logger::debug("[execute_tool] Script: " + tool.script);
         utils::Logger::debug("[execute_tool] Full command: " + cmd);
         utils::Logger::debug("[execute_tool] Args JSON: " + args_json);
         
-        // Execute
-        std::array<char, 256> buffer;
-        std::string result;
-        std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd.c_str(), "r"), pclose);
-    
-        if (!pipe) {
-            utils::Logger::error("[execute_tool] popen() failed for: " + cmd);
-            return "Error: Failed to execute tool script";
+        // Execute on a warm worker when the zygote is up, else spawn directly.
+        // Either way the process group is killed once a manifest limit is hit.
+        tool_exec::Limits limits;
+        limits.timeout_ms = tool.timeout_ms;
+        limits.max_output_bytes = tool.max_output_bytes;
+        bool ran = false;
+        if (use_zygote) {
+            ZygotePool::Policy mode = direct ? ZygotePool::Policy::Checked
+                                    : (exec_dangerous == "YES") ? ZygotePool::Policy::Approve
+                                    : ZygotePool::Policy::Refuse;
+            ran = zygote.run(mode, program, result, &cancel, limits, &info.outcome, cgroup, sink);
         }
-    
-        while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-            result += buffer.data();
+        if (!ran) ran = tool_exec::run(argv, result, &cancel, limits, &info.outcome, sink);
+        info.usage = cgroups.finish(cgroup);
+        if (!ran) {
+            utils::Logger::error("[execute_tool] spawn failed for: " + cmd);
+            return "Error: Failed to execute " + program[0];
+        }
+        if (direct && info.outcome == tool_exec::Outcome::Completed) {
+            // The trailer the dispatcher prints after an external command
+            std::string trailer = (result.empty() || result.back() == '\n') ? "" : "\n";
+            trailer += "External Command executed successfully\n";
+            result += trailer;
+            if (sink) sink(trailer.data(), trailer.size());
         }
     
         if (!result.empty() && result.back() == '\n') result.pop_back();
@@ -310,13 +452,68 @@ private:
         if (result.length() < 500) {
             utils::Logger::debug("[execute_tool] Result: " + result);
         }
+        if (info.outcome != tool_exec::Outcome::Completed) {
+            utils::Logger::error("[execute_tool] " + tool.name + " stopped early, returning partial output");
+        }
+        // Partial output from a cancelled or limited run is never kept
+        if (cacheable && info.outcome == tool_exec::Outcome::Completed) {
+            cache.put(tool.name, args, result, tool.cache_ttl_ms);
+        }
         
         return result;
     }
 };
 
-int main() {
-    MCPServerApp server;
+// Usage: mcp_server [--workers N] [--max-concurrent tool=N]... [--tools-dir DIR] [--proc-ttl MS] [--cache-mb N]
+//                   [--zygote-workers N] [--worker-jobs N] [--cgroups] [--cgroup-root DIR]
+//                   [--shell-session]
+int main(int argc, char** argv) {
+    size_t workers = 4;
+    // Tools are installed globally to /usr/local/share/ollmcpc/tools
+    // This allows running ollmcpc from any directory
+    std::string tools_dir = "/usr/local/share/ollmcpc/tools";
+    size_t cache_mb = 8;
+    int zygote_workers = -1;   // default: one warm worker per pool thread
+    int worker_jobs = 100;
+    bool use_cgroups = false;
+    std::string cgroup_root;
+    bool shell_session = false;
+    std::vector<std::pair<std::string, int>> limits;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--workers" && i + 1 < argc) {
+            workers = (size_t)std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--max-concurrent" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t eq = spec.find('=');
+            if (eq != std::string::npos) {
+                limits.push_back({spec.substr(0, eq), std::atoi(spec.c_str() + eq + 1)});
+            }
+        } else if (arg == "--tools-dir" && i + 1 < argc) {
+            tools_dir = argv[++i];
+        } else if (arg == "--proc-ttl" && i + 1 < argc) {
+            native_tools::setSnapshotTtl(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--cache-mb" && i + 1 < argc) {
+            cache_mb = (size_t)std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--zygote-workers" && i + 1 < argc) {
+            zygote_workers = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--worker-jobs" && i + 1 < argc) {
+            worker_jobs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--cgroups") {
+            use_cgroups = true;
+        } else if (arg == "--cgroup-root" && i + 1 < argc) {
+            use_cgroups = true;
+            cgroup_root = argv[++i];
+        } else if (arg == "--shell-session") {
+            shell_session = true;
+        }
+    }
+
+    MCPServerApp server(workers, tools_dir, cache_mb * 1024 * 1024,
+                        zygote_workers < 0 ? workers : (size_t)zygote_workers, worker_jobs);
+    for (const auto& l : limits) server.setToolLimit(l.first, l.second);
+    if (use_cgroups) server.enableCgroups(cgroup_root);
+    if (shell_session) server.enableShellSession();
     server.run();
     return 0;
 }
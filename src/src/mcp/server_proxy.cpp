@@ -1,12 +1,13 @@
 #include "mcp/server_proxy.hpp"
+#include "mcp/http_transport.hpp"
 #include "utils/json.hpp"
 #include "utils/jsonrpc.hpp"
+#include "utils/cancel.hpp"
+#include "utils/logger.hpp"
 #include <iostream>
-#include <unistd.h>
-#include <sys/wait.h>
-#include <signal.h>
-#include <cstdlib>
-MCPServer::MCPServer(const std::string& name) : server_name(name), request_id(0), pid(-1) {}
+#include <algorithm>
+MCPServer::MCPServer(const std::string& name)
+    : request_id(0), server_name(name), request_timeout_ms(30000) {}
 
 MCPServer::~MCPServer() {
     disconnect();
@@ -14,43 +15,20 @@ MCPServer::~MCPServer() {
 
 bool MCPServer::connect(const std::vector<std::string>& command) {
     server_command = command;
-    if (pipe(stdin_pipe) < 0 || pipe(stdout_pipe) < 0) {
-        std::cerr << "Failed to create pipes\n";
-        return false;
-    }
-    
-    pid = fork();
-    if (pid < 0) {
-        std::cerr << "Failed to fork\n";
+    return attach(std::make_unique<StdioTransport>(command));
+}
+
+bool MCPServer::connectRemote(const std::string& url) {
+    server_url = url;
+    return attach(std::make_unique<HttpTransport>(url));
+}
+
+bool MCPServer::attach(std::unique_ptr<MCPTransport> t) {
+    if (!t->open()) {
+        std::cerr << "Failed to open transport (" << t->describe() << ")\n";
         return false;
     }
-    
-    if (pid == 0) {
-        // Child process
-        close(stdin_pipe[1]);
-        close(stdout_pipe[0]);
-        
-        dup2(stdin_pipe[0], STDIN_FILENO);
-        dup2(stdout_pipe[1], STDOUT_FILENO);
-        
-        close(stdin_pipe[0]);
-        close(stdout_pipe[1]);
-        
-        std::vector<char*> args;
-        for (const auto& arg : command) {
-            args.push_back(const_cast<char*>(arg.c_str()));
-        }
-        args.push_back(nullptr);
-        
-        execvp(args[0], args.data());
-        std::cerr << "Failed to exec server\n";
-        exit(1);
-    }
-    
-    // Parent process
-    close(stdin_pipe[0]);
-    close(stdout_pipe[1]);
-    
+    transport = std::move(t);
     return initialize();
 }
 //cite https://modelcontextprotocol.io/specification/2025-06-18/schema
@@ -77,64 +55,116 @@ bool MCPServer::initialize() {
     return true;
 }
 
-std::string MCPServer::sendRequest(const std::string& method, const std::string& params) {
+std::string MCPServer::sendRequest(const std::string& method, const std::string& params, int timeout_ms) {
+    if (!transport) return "";
     int id = ++request_id;
-    std::string json_msg = jsonrpc::request(id, method, params) + "\n";
-    write(stdin_pipe[1], json_msg.c_str(), json_msg.length());
-    return readResponse();
+    last_error.clear();
+    Deadline deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(timeout_ms > 0 ? timeout_ms : request_timeout_ms);
+
+    if (!transport->send(jsonrpc::request(id, method, params), deadline, true)) {
+        // HTTP waits for the reply inside send(), so a deadline or Ctrl-C lands here
+        if (utils::CancelScope::requested()) cancelRequest(id, "cancelled by user");
+        else if (std::chrono::steady_clock::now() >= deadline) cancelRequest(id, "deadline exceeded");
+        return "";
+    }
+    return readResponse(id, deadline);
 }
 
 void MCPServer::sendNotification(const std::string& method, const std::string& params) {
-    std::string json_msg = jsonrpc::notification(method, params) + "\n";
-    write(stdin_pipe[1], json_msg.c_str(), json_msg.length());
+    if (!transport) return;
+    transport->send(jsonrpc::notification(method, params),
+                    std::chrono::steady_clock::now() + std::chrono::seconds(5), false);
 }
 
-#include "utils/logger.hpp"
-#include <poll.h>
+void MCPServer::cancelRequest(int id, const std::string& reason) {
+    last_error = reason;
+    utils::Logger::debug("[" + server_name + "] cancelling request " + std::to_string(id) + ": " + reason);
+
+    std::map<std::string, std::string> params;
+    params["requestId"] = json::num(id);
+    params["reason"] = json::str(reason);
+    sendNotification("notifications/cancelled", json::obj(params));
+}
 
-std::string MCPServer::readResponse() {
+std::string MCPServer::readResponse(int id, Deadline deadline) {
     std::string line;
-    char c;
+    auto window = deadline - std::chrono::steady_clock::now();
     
-    // We expect JSON-RPC messages to be on a single line ending in \n
-    // Many servers print logs or npx info to stdout, so we skip non-JSON lines
+    // Many servers print logs or npx info to stdout, so we skip non-JSON lines.
+    // Replies to earlier requests that were cancelled may still show up here;
+    // they are dropped by id instead of being mistaken for this answer.
     
-    int retries = 300; // Try reading for up to 30 seconds (slow APIs like Monica AI)
-    while (retries-- > 0) {
-        line = "";
-        bool found_json = false;
-        
-        // Read one line
-        while (true) {
-            ssize_t n = read(stdout_pipe[0], &c, 1);
-            if (n <= 0) break;
-            if (c == '\n') break;
-            line += c;
+    while (true) {
+        if (utils::CancelScope::requested()) {
+            cancelRequest(id, "cancelled by user");
+            return "";
         }
-        
-        if (line.empty()) {
-            usleep(100000); // 100ms
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            cancelRequest(id, "deadline exceeded");
+            return "";
+        }
+
+        // Wake up at least every 100ms to notice Ctrl-C
+        Deadline slice = std::min(deadline, now + std::chrono::milliseconds(100));
+        RecvStatus status = transport->receive(line, slice);
+        if (status == RecvStatus::Closed) {
+            last_error = "connection closed";
+            return "";
+        }
+        if (status == RecvStatus::Timeout || line.empty()) {
             continue;
         }
         
         // Check if it looks like JSON
         size_t first = line.find_first_not_of(" \t\r\n");
-        if (first != std::string::npos && line[first] == '{') {
-            utils::Logger::debug("[" + server_name + "] recv: " + line);
-            return line;
-        } else {
+        if (first == std::string::npos || line[first] != '{') {
             utils::Logger::debug("[" + server_name + "] junk: " + line);
+            continue;
+        }
+
+        // Streamed replies may carry server notifications ahead of the answer
+        if (json::parse::has_key(line, "method") && !json::parse::has_key(line, "result") &&
+            !json::parse::has_key(line, "error")) {
+            if (!progress_token.empty() &&
+                json::parse::get_string(line, "method") == "notifications/progress" &&
+                json::parse::get_string(line, "progressToken") == progress_token) {
+                // A tool that is still producing output is not stuck
+                deadline = std::chrono::steady_clock::now() + window;
+                std::string text = json::parse::get_string(line, "message");
+                progress_text += text;
+                if (progress_handler) progress_handler(text);
+                continue;
+            }
+            utils::Logger::debug("[" + server_name + "] notification: " + line);
+            continue;
+        }
+
+        std::string id_str = json_parse::extract_val(line, "\"id\":");
+        // Compared as text: a null id (parse error) or a string id is not ours
+        if (!id_str.empty() && id_str != std::to_string(id)) {
+            utils::Logger::debug("[" + server_name + "] dropping late reply for request " + id_str);
+            continue;
         }
+
+        utils::Logger::debug("[" + server_name + "] recv: " + line);
+        return line;
     }
-    
-    return "";
 }
 
 std::string MCPServer::listTools() {
     return sendRequest("tools/list", "{}");
 }
 
-std::string MCPServer::callTool(const std::string& tool_name, const std::string& arguments, int exec_dangerous) {
+std::string MCPServer::getStats() {
+    std::string response = sendRequest("server/stats", "{}");
+    std::string result = json::parse::get_object(response, "result");
+    return (result.empty() || result == "{}") ? "" : result;
+}
+
+std::string MCPServer::callTool(const std::string& tool_name, const std::string& arguments, int exec_dangerous,
+                                int timeout_ms) {
     std::map<std::string, std::string> params;
     params["name"] = json::str(tool_name);
     params["arguments"] = arguments;
@@ -143,8 +173,18 @@ std::string MCPServer::callTool(const std::string& tool_name, const std::string&
     if (server_name == "os-assistant") {
         params["exec_dangerous"] = json::str(exec_dangerous ? "YES" : "NO");
     }
+    progress_text.clear();
+    if (progress_handler) {
+        progress_token = server_name + "-" + std::to_string(++progress_seq);
+        params["_meta"] = "{\"progressToken\":" + json::str(progress_token) + "}";
+    }
     
-    std::string response = sendRequest("tools/call", json::obj(params));
+    std::string response = sendRequest("tools/call", json::obj(params), timeout_ms);
+    progress_token.clear();
+    last_resources = json::parse::get_object(response, "resources");
+    if (response.empty() && !last_error.empty() && last_error != "connection closed") {
+        return "Error: tool '" + tool_name + "' " + last_error + " (server " + server_name + ")";
+    }
     
     // Check for JSON-RPC error first
     std::string error_msg = json::parse::get_string(response, "message");
@@ -152,6 +192,18 @@ std::string MCPServer::callTool(const std::string& tool_name, const std::string&
         return "MCP error: " + error_msg;
     }
     
+    // A streamed result repeats only a summary and the tail; the full output
+    // is what arrived through notifications/progress
+    if (!progress_text.empty()) {
+        if (progress_text.back() == '\n') progress_text.pop_back();
+        // Keep the note a limited run ends with ("[Error: ... timed out ...]")
+        std::string text = json_parse::extract_string(json_parse::extract_array(response, "content"), "text");
+        size_t last = text.rfind('\n');
+        std::string tail = (last == std::string::npos) ? text : text.substr(last + 1);
+        if (tail.compare(0, 7, "[Error:") == 0) progress_text += "\n" + tail;
+        return progress_text;
+    }
+
     // Extract the text content from the response
     std::string content_array = json_parse::extract_array(response, "content");
     if (!content_array.empty()) {
@@ -163,11 +215,8 @@ std::string MCPServer::callTool(const std::string& tool_name, const std::string&
 }
 
 void MCPServer::disconnect() {
-    if (pid > 0) {
-        close(stdin_pipe[1]);
-        close(stdout_pipe[0]);
-        kill(pid, SIGTERM);
-        waitpid(pid, nullptr, 0);
-        pid = -1;
+    if (transport) {
+        transport->close();
+        transport.reset();
     }
 }
@@ -0,0 +1,344 @@
+#include "mcp/shell_session.hpp"
+#include "utils/logger.hpp"
+#include "dispatch_policy.h"
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+// 'text' as one single-quoted shell word
+static std::string shell_quote(const std::string& text) {
+    std::string quoted = "'";
+    for (char c : text) {
+        if (c == '\'') quoted += "'\\''";
+        else if (c != '\0') quoted += c;
+    }
+    return quoted + "'";
+}
+
+static bool send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+ShellSession::ShellSession(const std::string& dispatcher_path, ToolCgroups& cgroups)
+    : dispatcher_path(dispatcher_path), cgroups(cgroups) {}
+
+ShellSession::~ShellSession() {
+    stop();
+}
+
+std::string ShellSession::init_script() const {
+    char cwd[4096];
+    std::string home = getcwd(cwd, sizeof(cwd)) ? cwd : "/";
+    // Programs the checks run are named by path, so no shell function can stand in
+    std::string env = access("/usr/bin/env", X_OK) == 0 ? "/usr/bin/env" : "/bin/env";
+    std::string script =
+        "__mcp_mark=" + marker + "\n"
+        "__mcp_dispatcher=" + shell_quote(dispatcher_path) + "\n"
+        "__mcp_env=" + env + "\n"
+        "__mcp_home=" + shell_quote(home) + "\n"   // the dispatcher writes its audit log here
+        "__mcp_refused=" + shell_quote(refused_file) + "\n"
+        "declare -a __mcp_w\n"                      // __mcp_check's scratch space
+        "declare -A __mcp_policy\n";
+    std::string functions = "__mcp_dispatch __mcp_ask __mcp_check __mcp_run_y __mcp_run_n";
+
+    // The dispatcher's policy table, as "dispatcher --policy" prints it
+    for (size_t i = 0; i < policy_count(); i++) {
+        const CommandMetadata* entry = policy_entry(i);
+        std::string name = entry->name;
+        script += "__mcp_policy[" + shell_quote(name) + "]=" + (entry->is_internal ? "internal" : "dangerous") + "\n";
+        if (entry->is_internal) {
+            script += name + "() { __mcp_dispatch " + name + " \"$@\"; }\n";
+            functions += " " + name;
+        }
+    }
+    for (size_t i = 0; policy_session_builtin(i); i++) {
+        script += "__mcp_policy[" + std::string(policy_session_builtin(i)) + "]=session\n";
+    }
+
+    // __mcp_check runs as the DEBUG trap, which is off while it runs, so it
+    // calls nothing a command could have redefined as a function: only
+    // keywords, assignments, our readonly functions and programs by path.
+    // It finds the command name of a simple command (past assignments; past
+    // wrappers such as env or sudo every word counts) and asks the
+    // dispatcher about listed names, session builtins, __mcp_ names and
+    // names that only expansion reveals ($BASH_COMMAND is the text before
+    // expansion; the dispatcher refuses those). A refusal skips the command
+    // (extdebug) and leaves $__mcp_refused behind for the server. Whether
+    // the user approved dangerous commands is which of __mcp_run_y and
+    // __mcp_run_n the command runs in, so nothing the command can assign.
+    script += R"SH(__mcp_dispatch() {
+    if [[ " ${FUNCNAME[*]} " == *" __mcp_run_y "* ]]; then
+        "$__mcp_env" -C "$__mcp_home" "$__mcp_dispatcher" -y "$@"
+    else
+        "$__mcp_env" -C "$__mcp_home" "$__mcp_dispatcher" -n "$@"
+    fi
+}
+__mcp_ask() {
+    if [[ " ${FUNCNAME[*]} " == *" __mcp_run_y "* ]]; then
+        "$__mcp_env" -C "$__mcp_home" "$__mcp_dispatcher" --check -y "$1"
+    else
+        "$__mcp_env" -C "$__mcp_home" "$__mcp_dispatcher" --check -n "$1"
+    fi || { { [[ -n refused ]]; } > "$__mcp_refused"; [[ -z refused ]]; }
+}
+__mcp_check() {
+    if [[ " ${FUNCNAME[*]} " != *" __mcp_run_"[yn]" "* || ${FUNCNAME[1]} == __mcp_dispatch ||
+          ${__mcp_policy[${FUNCNAME[1]}]} == internal || $1 == "${FUNCNAME[1]} "* ]]; then
+        [[ -n "framing, or inside our own functions" ]]
+    elif [[ ${__mcp_w@a} != a ]]; then
+        __mcp_ask __mcp_w
+    else
+        __mcp_w=("$1" "" "" "" "")   # rest, word, command seen, behind a wrapper, refused
+        while __mcp_w[0]=${__mcp_w[0]#"${__mcp_w[0]%%[![:space:]]*}"}
+              __mcp_w[1]=${__mcp_w[0]%%[[:space:]]*}
+              [[ -n ${__mcp_w[1]} ]]; do
+            __mcp_w[0]=${__mcp_w[0]#"${__mcp_w[1]}"}
+            __mcp_w[1]=${__mcp_w[1]//[\"\'\\]/}
+            if [[ ${__mcp_w[1]} == [A-Za-z_]*=* ]]; then
+                [[ -n "assignment" ]]
+            elif [[ -z ${__mcp_w[2]} && ${__mcp_w[1]} == @(command|exec|env|nohup|nice|sudo) ]]; then
+                __mcp_w[3]=wrapped
+            else
+                [[ -n ${__mcp_w[3]} ]] || __mcp_w[0]=
+                __mcp_w[2]=seen
+                if [[ ${__mcp_w[1]} == @('['|'[['|'(('|'{'|'}') ]]; then
+                    [[ -n "syntax" ]]
+                elif [[ ${__mcp_w[1]} == *[\$\`*?[{\(]* || ${__mcp_w[1]} == __mcp_* ||
+                        ${__mcp_policy[${__mcp_w[1]##*/}]} == @(dangerous|session) ]]; then
+                    __mcp_ask "${__mcp_w[1]}" || __mcp_w=("" "" "" "" refused)
+                fi
+            fi
+        done
+        [[ -z ${__mcp_w[4]} ]]
+    fi
+}
+__mcp_run_y() { eval "$1"; }
+__mcp_run_n() { eval "$1"; }
+)SH";
+    script +=
+        "readonly __mcp_mark __mcp_dispatcher __mcp_env __mcp_home __mcp_refused __mcp_policy\n"
+        "readonly -f " + functions + "\n"
+        "shopt -s extdebug\n"
+        "trap '__mcp_check \"$BASH_COMMAND\"' DEBUG\n";
+    return script;
+}
+
+bool ShellSession::start(const ToolMeta& tool) {
+    int in_pair[2];
+    int out_pipe[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, in_pair) < 0) return false;
+    if (pipe2(out_pipe, O_CLOEXEC) < 0) {
+        close(in_pair[0]);
+        close(in_pair[1]);
+        return false;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, in_pair[1], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDERR_FILENO);
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attr, 0);
+
+    const char* argv[] = {"/bin/bash", "--noprofile", "--norc", nullptr};
+    int rc = posix_spawn(&pid, argv[0], &actions, &attr, const_cast<char**>(argv), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    close(in_pair[1]);
+    close(out_pipe[1]);
+    if (rc != 0) {
+        pid = -1;
+        close(in_pair[0]);
+        close(out_pipe[0]);
+        utils::Logger::error(std::string("[shell_session] cannot start /bin/bash: ") + strerror(rc));
+        return false;
+    }
+    in_fd = in_pair[0];
+    out_fd = out_pipe[0];
+
+    // Move the shell into its cgroup before it runs anything
+    cgroup = cgroups.create(tool.name, tool.cgroup);
+    if (!cgroup.empty()) {
+        int fd = open((cgroup + "/cgroup.procs").c_str(), O_WRONLY | O_CLOEXEC);
+        std::string value = std::to_string(pid);
+        if (fd < 0 || write(fd, value.data(), value.size()) < 0) {
+            utils::Logger::error("[shell_session] cannot join " + cgroup);
+        }
+        if (fd >= 0) close(fd);
+    }
+
+    std::random_device rd;
+    std::ostringstream mark;
+    mark << "__MCP_DONE_" << std::hex << rd() << rd() << "__";
+    marker = mark.str();
+
+    // The checks leave a file here when they refuse a command
+    char dir[] = "/tmp/mcp_shell_XXXXXX";
+    if (!mkdtemp(dir)) {
+        utils::Logger::error(std::string("[shell_session] cannot create a session directory: ") + strerror(errno));
+        shutdown();
+        return false;
+    }
+    refused_dir = dir;
+    refused_file = refused_dir + "/refused";
+
+    if (!send_all(in_fd, init_script())) {
+        shutdown();
+        return false;
+    }
+    started++;
+    running = true;
+    utils::Logger::debug("[shell_session] started shell " + std::to_string(pid));
+    return true;
+}
+
+void ShellSession::shutdown() {
+    if (pid <= 0) return;
+    if (in_fd >= 0) close(in_fd);
+    in_fd = -1;
+    killpg(pid, SIGKILL);   // also background jobs the session left behind
+    if (out_fd >= 0) close(out_fd);
+    out_fd = -1;
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+    pid = -1;
+    running = false;
+    cgroups.finish(cgroup);   // also kills what is left in the session's cgroup
+    cgroup.clear();
+    if (!refused_dir.empty()) {
+        unlink(refused_file.c_str());
+        rmdir(refused_dir.c_str());
+        refused_dir.clear();
+    }
+}
+
+void ShellSession::stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    shutdown();
+}
+
+bool ShellSession::run(const ToolMeta& tool, const std::string& command, bool exec_dangerous,
+                       std::string& output, const CancelToken* cancel, tool_exec::Outcome* outcome,
+                       int* exit_status, bool* refused, const tool_exec::OutputSink& sink) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pid <= 0 && !start(tool)) return false;
+
+    // The DEBUG trap keeps $? for printf
+    std::string framed = std::string("__mcp_run_") + (exec_dangerous ? "y " : "n ") + shell_quote(command) +
+                         " </dev/null 2>&1; printf '\\n%s %d\\n' \"$__mcp_mark\" \"$?\"\n";
+    unlink(refused_file.c_str());
+    if (!send_all(in_fd, framed)) {
+        // The shell exited after the last command; start over once
+        shutdown();
+        if (!start(tool) || !send_all(in_fd, framed)) return false;
+    }
+    commands++;
+
+    tool_exec::Limits limits;
+    limits.timeout_ms = tool.timeout_ms;
+    limits.max_output_bytes = tool.max_output_bytes;
+    int status = -1;
+    tool_exec::Outcome result = collect(output, status, cancel, limits, sink);
+    if (refused) *refused = access(refused_file.c_str(), F_OK) == 0;
+    if (status < 0) {
+        // Stopped before the command finished, or exit / exec ended the shell:
+        // clear out the group either way and start fresh next time
+        if (result != tool_exec::Outcome::Completed) killed++;
+        shutdown();
+    }
+    if (outcome) *outcome = result;
+    if (exit_status) *exit_status = status;
+    return true;
+}
+
+tool_exec::Outcome ShellSession::collect(std::string& output, int& exit_status, const CancelToken* cancel,
+                                         const tool_exec::Limits& limits, const tool_exec::OutputSink& sink) {
+    using clock = std::chrono::steady_clock;
+    const auto never = clock::time_point::max();
+    auto deadline = limits.timeout_ms > 0 ? clock::now() + std::chrono::milliseconds(limits.timeout_ms) : never;
+    const std::string end = "\n" + marker + " ";
+    std::string pending;   // read but not yet passed on: may hold the start of the marker
+    size_t start_size = output.size();
+    char chunk[65536];
+
+    // Hand on pending[0, len), up to the output limit; false once over it
+    auto emit = [&](size_t len) {
+        size_t used = output.size() - start_size;
+        size_t room = limits.max_output_bytes == 0 ? len
+                    : limits.max_output_bytes - std::min(limits.max_output_bytes, used);
+        size_t kept = std::min(room, len);
+        output.append(pending, 0, kept);
+        if (sink && kept) sink(pending.data(), kept);
+        pending.erase(0, len);
+        return kept == len;
+    };
+
+    while (true) {
+        struct pollfd fds[2] = {{out_fd, POLLIN, 0}, {cancel ? cancel->fd() : -1, POLLIN, 0}};
+        int timeout = -1;
+        if (deadline != never) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count();
+            timeout = left > 0 ? (int)left : 0;
+        }
+        int ready = poll(fds, cancel ? 2 : 1, timeout);
+        if (ready < 0 && errno != EINTR) break;
+        if (cancel && cancel->cancelled()) {
+            emit(pending.size());
+            return tool_exec::Outcome::Cancelled;
+        }
+        if (clock::now() >= deadline) {
+            emit(pending.size());
+            return tool_exec::Outcome::TimedOut;
+        }
+        if (ready <= 0 || !(fds[0].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+        ssize_t n = read(out_fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        pending.append(chunk, (size_t)n);
+
+        size_t at = pending.find(end);
+        if (at != std::string::npos) {
+            size_t eol = pending.find('\n', at + end.size());
+            if (eol == std::string::npos) continue;   // status not complete yet
+            exit_status = std::atoi(pending.c_str() + at + end.size());
+            pending.resize(at);
+            return emit(at) ? tool_exec::Outcome::Completed : tool_exec::Outcome::OutputLimit;
+        }
+        // Keep back only a tail that could be the start of the marker
+        size_t keep = std::min(pending.size(), end.size() - 1);
+        while (keep > 0 && pending.compare(pending.size() - keep, keep, end, 0, keep) != 0) keep--;
+        if (!emit(pending.size() - keep)) return tool_exec::Outcome::OutputLimit;
+    }
+    // EOF: the shell is gone (exit, exec, or killed from outside)
+    return emit(pending.size()) ? tool_exec::Outcome::Completed : tool_exec::Outcome::OutputLimit;
+}
+
+std::string ShellSession::statsJson() const {
+    return "{\"running\":" + std::string(running ? "true" : "false") +
+           ",\"started\":" + std::to_string(started) +
+           ",\"commands\":" + std::to_string(commands) +
+           ",\"killed\":" + std::to_string(killed) + "}";
+}
@@ -0,0 +1,189 @@
+#include "mcp/tool_cgroups.hpp"
+#include "utils/json.hpp"
+#include "utils/logger.hpp"
+#include <cerrno>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static bool write_file(const std::string& path, const std::string& value) {
+    int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool ok = write(fd, value.data(), value.size()) == (ssize_t)value.size();
+    close(fd);
+    return ok;
+}
+
+static std::string read_file(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) return "";
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+// Value of "key N" in a flat keyed file such as cpu.stat or cgroup.events
+static uint64_t keyed_value(const std::string& content, const std::string& key) {
+    std::istringstream in(content);
+    std::string k;
+    uint64_t v;
+    while (in >> k >> v) {
+        if (k == key) return v;
+    }
+    return 0;
+}
+
+// Mount point of the cgroup2 hierarchy (/sys/fs/cgroup, or .../unified on hybrid hosts)
+static std::string cgroup2_mount() {
+    std::ifstream mounts("/proc/self/mountinfo");
+    std::string line;
+    while (std::getline(mounts, line)) {
+        size_t sep = line.find(" - ");
+        if (sep == std::string::npos || line.compare(sep + 3, 8, "cgroup2 ") != 0) continue;
+        std::istringstream in(line.substr(0, sep));
+        std::string field;
+        for (int i = 0; i < 5 && in >> field; i++) {}
+        return field;
+    }
+    return "";
+}
+
+std::string ResourceUsage::json() const {
+    return "{\"cpu_ms\":" + std::to_string(cpu_usec / 1000) +
+           ",\"user_ms\":" + std::to_string(user_usec / 1000) +
+           ",\"system_ms\":" + std::to_string(system_usec / 1000) +
+           ",\"memory_peak_kb\":" + std::to_string(memory_peak / 1024) +
+           ",\"io_read_kb\":" + std::to_string(io_read / 1024) +
+           ",\"io_write_kb\":" + std::to_string(io_write / 1024) + "}";
+}
+
+bool ToolCgroups::init(const std::string& root_dir) {
+    std::string mount = cgroup2_mount();
+    if (mount.empty()) {
+        reason = "cgroup v2 is not mounted";
+        utils::Logger::error("Tool cgroups disabled: " + reason);
+        return false;
+    }
+
+    std::string dir = root_dir;
+    if (dir.empty()) {
+        std::ifstream self("/proc/self/cgroup");
+        std::string line;
+        while (std::getline(self, line)) {
+            if (line.compare(0, 3, "0::") == 0) dir = mount + line.substr(3);
+        }
+        if (!dir.empty() && dir.back() == '/') dir.pop_back();
+
+        // A non-root cgroup with processes in it cannot delegate controllers
+        // to children, so move this process into a leaf of its own
+        if (dir != mount) {
+            std::string leaf = dir + "/mcp_server";
+            if ((mkdir(leaf.c_str(), 0755) < 0 && errno != EEXIST) ||
+                !write_file(leaf + "/cgroup.procs", std::to_string(getpid()))) {
+                utils::Logger::debug("Tool cgroups: cannot move mcp_server into " + leaf + ": " + strerror(errno));
+            }
+        }
+    }
+
+    // Prove we may create children here before promising anything
+    std::string probe = dir + "/tool-probe-" + std::to_string(getpid());
+    if (mkdir(probe.c_str(), 0755) < 0) {
+        reason = dir + " is not writable (" + std::string(strerror(errno)) + ")";
+        utils::Logger::error("Tool cgroups disabled: " + reason);
+        return false;
+    }
+    rmdir(probe.c_str());
+
+    std::istringstream available(read_file(dir + "/cgroup.controllers"));
+    std::string ctrl;
+    while (available >> ctrl) {
+        if (ctrl == "cpu" || ctrl == "memory" || ctrl == "io") {
+            write_file(dir + "/cgroup.subtree_control", "+" + ctrl);
+        }
+    }
+    controllers = read_file(dir + "/cgroup.subtree_control");
+    while (!controllers.empty() && std::isspace((unsigned char)controllers.back())) controllers.pop_back();
+
+    root = dir;
+    utils::Logger::debug("Tool cgroups under " + root + ", controllers: [" + controllers + "]");
+    return true;
+}
+
+bool ToolCgroups::has_controller(const std::string& name) const {
+    std::istringstream in(controllers);
+    std::string c;
+    while (in >> c) {
+        if (c == name) return true;
+    }
+    return false;
+}
+
+std::string ToolCgroups::create(const std::string& tool, const CgroupLimits& limits) {
+    if (root.empty()) return "";
+    std::string dir = root + "/tool-" + tool + "-" + std::to_string(++seq);
+    if (mkdir(dir.c_str(), 0755) < 0) {
+        utils::Logger::error("Tool cgroups: mkdir " + dir + ": " + strerror(errno));
+        return "";
+    }
+
+    auto apply = [&](const char* controller, const char* file, const std::string& value) {
+        if (value.empty() || !has_controller(controller)) return;
+        if (!write_file(dir + "/" + file, value)) {
+            utils::Logger::error("Tool cgroups: cannot set " + std::string(file) + "=" + value + " for " + tool);
+        }
+    };
+    apply("cpu", "cpu.weight", limits.cpu_weight > 0 ? std::to_string(limits.cpu_weight) : "");
+    apply("memory", "memory.max", limits.memory_max);
+    apply("io", "io.weight", limits.io_weight > 0 ? "default " + std::to_string(limits.io_weight) : "");
+    apply("io", "io.max", limits.io_max);
+    return dir;
+}
+
+ResourceUsage ToolCgroups::finish(const std::string& dir) {
+    ResourceUsage usage;
+    if (dir.empty()) return usage;
+
+    std::string cpu = read_file(dir + "/cpu.stat");
+    if (!cpu.empty()) {
+        usage.valid = true;
+        usage.cpu_usec = keyed_value(cpu, "usage_usec");
+        usage.user_usec = keyed_value(cpu, "user_usec");
+        usage.system_usec = keyed_value(cpu, "system_usec");
+    }
+    std::string peak = read_file(dir + "/memory.peak");
+    if (!peak.empty()) usage.memory_peak = std::strtoull(peak.c_str(), nullptr, 10);
+
+    // io.stat: "MAJ:MIN rbytes=N wbytes=N rios=N ..." per device
+    std::istringstream io(read_file(dir + "/io.stat"));
+    std::string token;
+    while (io >> token) {
+        if (token.compare(0, 7, "rbytes=") == 0) usage.io_read += std::strtoull(token.c_str() + 7, nullptr, 10);
+        else if (token.compare(0, 7, "wbytes=") == 0) usage.io_write += std::strtoull(token.c_str() + 7, nullptr, 10);
+    }
+
+    // Anything the tool left running (daemonized children) keeps the cgroup busy
+    if (rmdir(dir.c_str()) < 0 && errno == EBUSY) {
+        write_file(dir + "/cgroup.kill", "1");
+        for (int i = 0; i < 50 && keyed_value(read_file(dir + "/cgroup.events"), "populated"); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        if (rmdir(dir.c_str()) < 0) {
+            utils::Logger::error("Tool cgroups: cannot remove " + dir + ": " + strerror(errno));
+        }
+    }
+    return usage;
+}
+
+std::string ToolCgroups::statusJson() const {
+    return "{\"available\":" + std::string(root.empty() ? "false" : "true") +
+           ",\"root\":" + json::str(root) +
+           ",\"controllers\":" + json::str(controllers) +
+           ",\"reason\":" + json::str(reason) + "}";
+}
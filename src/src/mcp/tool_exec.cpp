@@ -0,0 +1,159 @@
+#include "mcp/tool_exec.hpp"
+#include "utils/logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/wait.h>
+
+CancelToken::CancelToken() : flag(false), event_fd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {}
+
+CancelToken::~CancelToken() {
+    if (event_fd >= 0) close(event_fd);
+}
+
+void CancelToken::cancel() {
+    if (flag.exchange(true)) return;
+    if (event_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t n = write(event_fd, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+namespace tool_exec {
+
+std::vector<std::string> split_command_words(const std::string& line) {
+    std::vector<std::string> words;
+    std::string word;
+    bool in_word = false;
+    char quote = 0;
+    for (size_t i = 0; i < line.length(); i++) {
+        char c = line[i];
+        if (quote) {
+            if (c == quote) quote = 0;
+            else if (c == '\\' && quote == '"' && i + 1 < line.length()) word += line[++i];
+            else word += c;
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+            in_word = true;
+        } else if (c == '\\' && i + 1 < line.length()) {
+            word += line[++i];
+            in_word = true;
+        } else if (std::isspace((unsigned char)c)) {
+            if (in_word) words.push_back(word);
+            word.clear();
+            in_word = false;
+        } else {
+            word += c;
+            in_word = true;
+        }
+    }
+    if (in_word) words.push_back(word);
+    return words;
+}
+
+bool run(const std::vector<std::string>& argv, std::string& output, const CancelToken* cancel,
+         const Limits& limits, Outcome* outcome, const OutputSink& sink) {
+    if (argv.empty()) return false;
+
+    int out_pipe[2];
+    if (pipe2(out_pipe, O_CLOEXEC) < 0) return false;
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attr, 0);
+
+    std::vector<char*> c_argv;
+    for (const auto& a : argv) c_argv.push_back(const_cast<char*>(a.c_str()));
+    c_argv.push_back(nullptr);
+
+    pid_t pid;
+    int rc = posix_spawnp(&pid, c_argv[0], &actions, &attr, c_argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    close(out_pipe[1]);
+    if (rc != 0) {
+        close(out_pipe[0]);
+        return false;
+    }
+
+    Outcome result = collect(out_pipe[0], pid, output, cancel, limits, sink);
+    if (outcome) *outcome = result;
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+    return true;
+}
+
+Outcome collect(int out_fd, pid_t pgid, std::string& output, const CancelToken* cancel,
+                const Limits& limits, const OutputSink& sink) {
+    using clock = std::chrono::steady_clock;
+    const auto never = clock::time_point::max();
+    Outcome outcome = Outcome::Completed;
+    bool term_sent = false;
+    auto deadline = limits.timeout_ms > 0 ? clock::now() + std::chrono::milliseconds(limits.timeout_ms) : never;
+    auto kill_at = never;
+    size_t start_size = output.size();
+    char chunk[65536];   // large reads: fewer wakeups and fewer progress frames
+
+    auto stop = [&](Outcome why, const char* reason) {
+        utils::Logger::debug(std::string("[tool_exec] ") + reason + ", stopping process group " +
+                             std::to_string(pgid));
+        if (pgid > 1) killpg(pgid, SIGTERM);
+        outcome = why;
+        term_sent = true;
+        kill_at = clock::now() + std::chrono::milliseconds(KILL_GRACE_MS);
+    };
+
+    while (true) {
+        struct pollfd fds[2] = {{out_fd, POLLIN, 0}, {cancel ? cancel->fd() : -1, POLLIN, 0}};
+        auto next = term_sent ? kill_at : deadline;
+        int timeout = -1;
+        if (next != never) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(next - clock::now()).count();
+            timeout = left > 0 ? (int)left : 0;
+        }
+
+        int ready = poll(fds, (cancel && !term_sent) ? 2 : 1, timeout);
+        if (ready < 0 && errno != EINTR) break;
+
+        if (!term_sent) {
+            if (cancel && cancel->cancelled()) stop(Outcome::Cancelled, "cancelled");
+            else if (clock::now() >= deadline) stop(Outcome::TimedOut, "time limit reached");
+        } else if (clock::now() >= kill_at) {
+            if (pgid > 1) killpg(pgid, SIGKILL);
+            kill_at = never;
+        }
+
+        if (ready > 0 && (fds[0].revents & (POLLIN | POLLHUP | POLLERR))) {
+            ssize_t n = read(out_fd, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            size_t room = limits.max_output_bytes == 0 ? (size_t)n
+                        : limits.max_output_bytes - std::min(limits.max_output_bytes, output.size() - start_size);
+            size_t kept = std::min(room, (size_t)n);
+            output.append(chunk, kept);
+            if (sink && kept) sink(chunk, kept);
+            // Keep draining after the limit so the group never blocks on a full pipe
+            if ((size_t)n > room && !term_sent) stop(Outcome::OutputLimit, "output limit reached");
+        }
+    }
+    close(out_fd);
+    if (term_sent && pgid > 1) killpg(pgid, SIGKILL); // stragglers that closed stdout early
+    return outcome;
+}
+
+} // namespace tool_exec
@@ -0,0 +1,136 @@
+#include "mcp/tool_registry.hpp"
+#include "utils/json.hpp"
+#include "utils/logger.hpp"
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+
+ToolRegistry::ToolRegistry(const std::string& manifest_path)
+    : manifest_path(manifest_path), snapshot(std::make_shared<Snapshot>()) {}
+
+std::shared_ptr<const ToolRegistry::Snapshot> ToolRegistry::current() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return snapshot;
+}
+
+ToolMeta ToolRegistry::parse_tool(const std::string& obj) {
+    ToolMeta meta;
+    for (const auto& member : json::parse::members(obj)) {
+        const std::string& key = member.first;
+        const std::string& raw = member.second;
+        if (key == "name") meta.name = json::parse::scalar(raw);
+        else if (key == "script") meta.script = json::parse::scalar(raw);
+        else if (key == "description") meta.description = json::parse::scalar(raw);
+        else if (key == "inputSchema") meta.inputSchema = raw;
+        else if (key == "run") meta.run = json::parse::scalar(raw);
+        else if (key == "safety") meta.safety = json::parse::scalar(raw);
+        else if (key == "timeout_ms") meta.timeout_ms = std::stoi(raw);
+        else if (key == "max_output_bytes") meta.max_output_bytes = std::stoul(raw);
+        else if (key == "cpu_weight") meta.cgroup.cpu_weight = std::stoi(raw);
+        else if (key == "memory_max") meta.cgroup.memory_max = json::parse::scalar(raw);
+        else if (key == "io_weight") meta.cgroup.io_weight = std::stoi(raw);
+        else if (key == "io_max") meta.cgroup.io_max = json::parse::scalar(raw);
+        else if (key == "max_concurrent") meta.max_concurrent = std::stoi(raw);
+        else if (key == "cache_ttl_ms") meta.cache_ttl_ms = std::stoi(raw);
+        else if (key == "native") meta.native = (raw == "true");
+        else if (key == "stream") meta.stream = (raw == "true");
+        else if (key == "args") {
+            for (const auto& item : json::parse::items(raw)) {
+                ToolArg arg;
+                for (const auto& f : json::parse::members(item)) {
+                    if (f.first == "key") arg.key = json::parse::scalar(f.second);
+                    else if (f.first == "flag") arg.flag = json::parse::scalar(f.second);
+                    else if (f.first == "switch") arg.is_switch = (f.second == "true");
+                    else if (f.first == "required") arg.required = (f.second == "true");
+                    else if (f.first == "aliases") {
+                        for (const auto& a : json::parse::items(f.second)) {
+                            arg.aliases.push_back(json::parse::scalar(a));
+                        }
+                    }
+                }
+                if (!arg.key.empty()) meta.args.push_back(arg);
+            }
+        }
+    }
+    if (meta.inputSchema.empty()) meta.inputSchema = R"({"type":"object","properties":{}})";
+    meta.binder = ArgBinder(meta.name, meta.args, meta.inputSchema);
+    return meta;
+}
+
+bool ToolRegistry::load() {
+    std::ifstream file(manifest_path);
+    if (!file.is_open()) {
+        utils::Logger::error("Tool manifest not found: " + manifest_path);
+        return false;
+    }
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::string tools_arr = json::parse::get_array(content, "tools");
+    if (tools_arr.empty()) {
+        utils::Logger::error("Tool manifest has no \"tools\" array: " + manifest_path);
+        return false;
+    }
+
+    auto next = std::make_shared<Snapshot>();
+    std::string list = "{\"tools\":[";
+    try {
+        for (const auto& obj : json::parse::items(tools_arr)) {
+            // Entries can be parked with "enabled": false
+            bool enabled = true;
+            for (const auto& m : json::parse::members(obj)) {
+                if (m.first == "enabled" && m.second == "false") enabled = false;
+            }
+            if (!enabled) continue;
+
+            auto meta = std::make_shared<const ToolMeta>(parse_tool(obj));
+            if (meta->name.empty() || next->by_name.count(meta->name)) continue;
+
+            if (!next->ordered.empty()) list += ",";
+            list += "{\"name\":" + json::str(meta->name) +
+                    ",\"description\":" + json::str(meta->description) +
+                    ",\"inputSchema\":" + meta->inputSchema + "}";
+
+            next->by_name[meta->name] = meta;
+            next->ordered.push_back(meta);
+        }
+    } catch (const std::exception& e) {
+        utils::Logger::error("Tool manifest " + manifest_path + " is malformed: " + e.what());
+        return false;
+    }
+    list += "]}";
+    next->tools_list = list;
+
+    struct stat st;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stat(manifest_path.c_str(), &st) == 0) loaded_mtime = st.st_mtime;
+    snapshot = next;
+    utils::Logger::debug("Loaded " + std::to_string(next->ordered.size()) + " tools from " + manifest_path);
+    return true;
+}
+
+bool ToolRegistry::reloadIfChanged() {
+    std::time_t now = std::time(nullptr);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (now == last_check) return false;
+        last_check = now;
+
+        struct stat st;
+        if (stat(manifest_path.c_str(), &st) != 0 || st.st_mtime == loaded_mtime) return false;
+    }
+    return load();
+}
+
+std::shared_ptr<const ToolMeta> ToolRegistry::find(const std::string& name) const {
+    auto snap = current();
+    auto it = snap->by_name.find(name);
+    return it == snap->by_name.end() ? nullptr : it->second;
+}
+
+std::string ToolRegistry::toolsListResult() const {
+    return current()->tools_list;
+}
+
+std::vector<std::shared_ptr<const ToolMeta>> ToolRegistry::all() const {
+    return current()->ordered;
+}
@@ -0,0 +1,62 @@
+#include "mcp/tool_stats.hpp"
+#include "utils/json.hpp"
+#include <algorithm>
+#include <cstdio>
+
+void ToolStats::Timing::add(double queue_ms, double exec_ms, tool_exec::Outcome outcome) {
+    calls++;
+    if (outcome == tool_exec::Outcome::TimedOut) timeouts++;
+    if (outcome == tool_exec::Outcome::OutputLimit) output_limited++;
+    queue_ms_total += queue_ms;
+    queue_ms_max = std::max(queue_ms_max, queue_ms);
+    exec_ms_total += exec_ms;
+    exec_ms_max = std::max(exec_ms_max, exec_ms);
+}
+
+std::string ToolStats::Timing::fields() const {
+    char buf[256];
+    double n = calls ? (double)calls : 1.0;
+    snprintf(buf, sizeof(buf),
+             "\"calls\":%llu,\"queue_ms_avg\":%.3f,\"queue_ms_max\":%.3f,"
+             "\"exec_ms_avg\":%.3f,\"exec_ms_max\":%.3f,"
+             "\"timeouts\":%llu,\"timeout_rate\":%.3f,\"output_limited\":%llu",
+             (unsigned long long)calls, queue_ms_total / n, queue_ms_max,
+             exec_ms_total / n, exec_ms_max,
+             (unsigned long long)timeouts, timeouts / n, (unsigned long long)output_limited);
+    std::string out = buf;
+    if (measured) {
+        snprintf(buf, sizeof(buf),
+                 ",\"measured\":%llu,\"cpu_ms_avg\":%.3f,\"cpu_ms_total\":%.3f,\"memory_peak_kb_max\":%llu",
+                 (unsigned long long)measured, cpu_usec_total / 1000.0 / measured, cpu_usec_total / 1000.0,
+                 (unsigned long long)(memory_peak_max / 1024));
+        out += buf;
+    }
+    return out;
+}
+
+void ToolStats::record(const std::string& tool, double queue_ms, double exec_ms,
+                       tool_exec::Outcome outcome) {
+    std::lock_guard<std::mutex> lock(mutex);
+    total.add(queue_ms, exec_ms, outcome);
+    per_tool[tool].add(queue_ms, exec_ms, outcome);
+}
+
+void ToolStats::recordUsage(const std::string& tool, const ResourceUsage& usage) {
+    if (!usage.valid) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Timing* t : {&total, &per_tool[tool]}) {
+        t->measured++;
+        t->cpu_usec_total += usage.cpu_usec;
+        t->memory_peak_max = std::max(t->memory_peak_max, usage.memory_peak);
+    }
+}
+
+std::string ToolStats::statsJson() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string tools;
+    for (const auto& t : per_tool) {
+        if (!tools.empty()) tools += ",";
+        tools += json::str(t.first) + ":{" + t.second.fields() + "}";
+    }
+    return "{" + total.fields() + ",\"tools\":{" + tools + "}}";
+}
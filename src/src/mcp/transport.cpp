@@ -0,0 +1,113 @@
+#include "mcp/transport.hpp"
+#include <iostream>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <poll.h>
+#include <cerrno>
+#include <cstdlib>
+
+StdioTransport::StdioTransport(const std::vector<std::string>& command)
+    : command(command), pid(-1) {}
+
+StdioTransport::~StdioTransport() {
+    close();
+}
+
+bool StdioTransport::open() {
+    if (command.empty()) return false;
+    if (pipe(stdin_pipe) < 0 || pipe(stdout_pipe) < 0) {
+        std::cerr << "Failed to create pipes\n";
+        return false;
+    }
+
+    pid = fork();
+    if (pid < 0) {
+        std::cerr << "Failed to fork\n";
+        return false;
+    }
+
+    if (pid == 0) {
+        // Child process. Own process group, so a Ctrl-C aimed at the client
+        // (which is turned into an MCP cancellation) does not kill the server.
+        setpgid(0, 0);
+        ::close(stdin_pipe[1]);
+        ::close(stdout_pipe[0]);
+
+        dup2(stdin_pipe[0], STDIN_FILENO);
+        dup2(stdout_pipe[1], STDOUT_FILENO);
+
+        ::close(stdin_pipe[0]);
+        ::close(stdout_pipe[1]);
+
+        std::vector<char*> args;
+        for (const auto& arg : command) {
+            args.push_back(const_cast<char*>(arg.c_str()));
+        }
+        args.push_back(nullptr);
+
+        execvp(args[0], args.data());
+        std::cerr << "Failed to exec server\n";
+        exit(1);
+    }
+
+    // Parent process
+    ::close(stdin_pipe[0]);
+    ::close(stdout_pipe[1]);
+    return true;
+}
+
+bool StdioTransport::send(const std::string& message, Deadline, bool) {
+    if (pid <= 0) return false;
+    std::string line = message + "\n";
+    return write(stdin_pipe[1], line.c_str(), line.length()) == (ssize_t)line.length();
+}
+
+RecvStatus StdioTransport::receive(std::string& line, Deadline deadline) {
+    // We expect JSON-RPC messages to be on a single line ending in \n
+    while (true) {
+        size_t nl = read_buffer.find('\n');
+        if (nl != std::string::npos) {
+            line = read_buffer.substr(0, nl);
+            read_buffer.erase(0, nl + 1);
+            return RecvStatus::Line;
+        }
+        if (pid <= 0) return RecvStatus::Closed;
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) return RecvStatus::Timeout;
+
+        struct pollfd pfd = {stdout_pipe[0], POLLIN, 0};
+        int ready = poll(&pfd, 1, (int)remaining);
+        if (ready < 0 && errno == EINTR) return RecvStatus::Timeout; // let caller check for Ctrl-C
+        if (ready <= 0) continue;
+
+        char chunk[4096];
+        ssize_t n = read(stdout_pipe[0], chunk, sizeof(chunk));
+        if (n <= 0) {
+            if (read_buffer.empty()) return RecvStatus::Closed;
+            line = read_buffer;
+            read_buffer.clear();
+            return RecvStatus::Line;
+        }
+        read_buffer.append(chunk, n);
+    }
+}
+
+void StdioTransport::close() {
+    if (pid > 0) {
+        ::close(stdin_pipe[1]);
+        ::close(stdout_pipe[0]);
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+        pid = -1;
+        read_buffer.clear();
+    }
+}
+
+std::string StdioTransport::describe() const {
+    std::string s = "stdio:";
+    for (const auto& c : command) s += " " + c;
+    return s;
+}
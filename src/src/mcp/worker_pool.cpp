@@ -0,0 +1,78 @@
+#include "mcp/worker_pool.hpp"
+#include "utils/logger.hpp"
+
+WorkerPool::WorkerPool(size_t count) {
+    if (count == 0) count = 1;
+    for (size_t i = 0; i < count; i++) {
+        threads.emplace_back(&WorkerPool::worker_loop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    shutdown();
+}
+
+void WorkerPool::setLimit(const std::string& key, int max_concurrent) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (max_concurrent > 0) limits[key] = max_concurrent;
+    else limits.erase(key);
+    cv.notify_all();
+}
+
+void WorkerPool::submit(const std::string& key, Job job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back({key, std::move(job)});
+    }
+    cv.notify_all();
+}
+
+void WorkerPool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping && threads.empty()) return;
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto& t : threads) {
+        if (t.joinable()) t.join();
+    }
+    threads.clear();
+}
+
+bool WorkerPool::runnable(const std::string& key) const {
+    auto limit = limits.find(key);
+    if (limit == limits.end()) return true;
+    auto count = running.find(key);
+    return count == running.end() || count->second < limit->second;
+}
+
+void WorkerPool::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        // First queued job whose tool is below its concurrency limit
+        auto it = queue.end();
+        cv.wait(lock, [&] {
+            for (it = queue.begin(); it != queue.end(); ++it) {
+                if (runnable(it->key)) return true;
+            }
+            return stopping && queue.empty();
+        });
+        if (it == queue.end()) return; // stopping, nothing left
+
+        Entry entry = std::move(*it);
+        queue.erase(it);
+        running[entry.key]++;
+
+        lock.unlock();
+        try {
+            entry.job();
+        } catch (const std::exception& e) {
+            utils::Logger::error("Worker job for " + entry.key + " threw: " + e.what());
+        }
+        lock.lock();
+
+        if (--running[entry.key] == 0) running.erase(entry.key);
+        cv.notify_all(); // a job held back by the limit may now run
+    }
+}
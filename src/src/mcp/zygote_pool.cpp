@@ -0,0 +1,258 @@
+#include "mcp/zygote_pool.hpp"
+#include "utils/logger.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+// Must match ZYGOTE_FD and JOB_MAX in tools/dispatcher.c
+static constexpr int ZYGOTE_FD = 3;
+static constexpr size_t JOB_MAX = 65536;
+
+static ssize_t recv_with_fd(int sock, char* buf, size_t len, int* fd) {
+    struct iovec iov = {buf, len};
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n;
+    do {
+        n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+
+    *fd = -1;
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (n > 0 && cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+        memcpy(fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+    return n;
+}
+
+static bool send_with_fd(int sock, const std::string& data, int fd) {
+    struct iovec iov = {const_cast<char*>(data.data()), data.size()};
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    struct msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    ssize_t n;
+    do {
+        n = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    return n == (ssize_t)data.size();
+}
+
+// One "<kind><number>" reply from a worker; false on EOF or a malformed packet
+static bool recv_reply(int sock, char& kind, long& value) {
+    char buf[32];
+    ssize_t n;
+    do {
+        n = recv(sock, buf, sizeof(buf) - 1, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n < 2) return false;
+    buf[n] = '\0';
+    kind = buf[0];
+    value = std::strtol(buf + 1, nullptr, 10);
+    return true;
+}
+
+ZygotePool::ZygotePool(const std::string& dispatcher_path, size_t warm, int max_jobs)
+    : dispatcher_path(dispatcher_path), warm(warm), max_jobs(max_jobs) {}
+
+ZygotePool::~ZygotePool() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& w : idle) close(w.sock);
+    idle.clear();
+    if (ctl >= 0) {
+        close(ctl); // the zygote exits when its control socket closes
+        ctl = -1;
+    }
+    if (zygote_pid > 0) {
+        int status;
+        while (waitpid(zygote_pid, &status, 0) < 0 && errno == EINTR) {}
+    }
+}
+
+bool ZygotePool::start() {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) < 0) return false;
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, sv[1], ZYGOTE_FD);
+
+    char* argv[] = {const_cast<char*>(dispatcher_path.c_str()), const_cast<char*>("--zygote"), nullptr};
+    int rc = posix_spawn(&zygote_pid, argv[0], &actions, nullptr, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(sv[1]);
+    if (rc != 0) {
+        close(sv[0]);
+        zygote_pid = -1;
+        utils::Logger::error("ZygotePool: cannot start " + dispatcher_path + ": " + strerror(rc));
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ctl = sv[0];
+    for (size_t i = 0; i < warm; i++) {
+        Worker w;
+        if (!spawn_worker(w)) break;
+        idle.push_back(w);
+    }
+    utils::Logger::debug("ZygotePool: zygote " + std::to_string(zygote_pid) + " with " +
+                         std::to_string(idle.size()) + " warm workers");
+    return ctl >= 0;
+}
+
+bool ZygotePool::spawn_worker(Worker& worker) {
+    if (ctl < 0) return false;
+    std::string req = "W" + std::to_string(max_jobs);
+    ssize_t sent;
+    do {
+        sent = send(ctl, req.data(), req.size(), MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+
+    char reply[32];
+    int fd = -1;
+    ssize_t n = sent < 0 ? -1 : recv_with_fd(ctl, reply, sizeof(reply) - 1, &fd);
+    if (n <= 0) {
+        // The zygote is gone; callers fall back to spawning directly
+        utils::Logger::error("ZygotePool: zygote stopped responding, disabling warm workers");
+        close(ctl);
+        ctl = -1;
+        return false;
+    }
+    reply[n] = '\0';
+    long pid = reply[0] == 'P' ? std::strtol(reply + 1, nullptr, 10) : -1;
+    if (pid <= 0 || fd < 0) {
+        if (fd >= 0) close(fd);
+        failed++;
+        return false;
+    }
+    worker.pid = (pid_t)pid;
+    worker.sock = fd;
+    worker.jobs = 0;
+    spawned++;
+    return true;
+}
+
+bool ZygotePool::acquire(Worker& worker) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!idle.empty()) {
+        worker = idle.back();
+        idle.pop_back();
+        return true;
+    }
+    // More concurrent jobs than warm workers: fork another one
+    return spawn_worker(worker);
+}
+
+void ZygotePool::retire(Worker& worker) {
+    close(worker.sock);
+    worker.sock = -1;
+}
+
+void ZygotePool::release(Worker& worker, bool healthy) {
+    bool worn_out = max_jobs > 0 && worker.jobs >= max_jobs;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (healthy && !worn_out) {
+        idle.push_back(worker);
+        return;
+    }
+    retire(worker);
+    if (healthy) recycled++;
+    else failed++;
+
+    // Keep the warm set at its configured size
+    if (idle.size() < warm) {
+        Worker fresh;
+        if (spawn_worker(fresh)) idle.push_back(fresh);
+    }
+}
+
+bool ZygotePool::run(Policy policy, const std::vector<std::string>& program_and_args,
+                     std::string& output, const CancelToken* cancel,
+                     const tool_exec::Limits& limits, tool_exec::Outcome* outcome,
+                     const std::string& cgroup, const tool_exec::OutputSink& sink) {
+    if (program_and_args.empty()) return false;
+
+    std::string packet = "J";
+    packet += policy == Policy::Checked ? 'x' : policy == Policy::Approve ? 'y' : 'n';
+    packet += cgroup;
+    packet += '\0';
+    for (const auto& a : program_and_args) {
+        packet += a;
+        packet += '\0';
+    }
+    if (packet.size() >= JOB_MAX) return false;
+
+    Worker w;
+    if (!acquire(w)) return false;
+
+    int out_pipe[2];
+    if (pipe2(out_pipe, O_CLOEXEC) < 0) {
+        release(w, true);
+        return false;
+    }
+    bool sent = send_with_fd(w.sock, packet, out_pipe[1]);
+    close(out_pipe[1]);
+    if (!sent) {
+        close(out_pipe[0]);
+        release(w, false);
+        return false;
+    }
+
+    // "S<pgid>" once the job is running, or "E-1" if the worker could not fork
+    char kind = 0;
+    long value = 0;
+    bool healthy = recv_reply(w.sock, kind, value);
+    if (healthy && kind == 'E') {
+        close(out_pipe[0]);
+        release(w, true);
+        return false;
+    }
+    pid_t pgid = (healthy && kind == 'S' && value > 1) ? (pid_t)value : -1;
+
+    // Without a process group collect() signals nothing and just reads to EOF
+    tool_exec::Outcome result = tool_exec::collect(out_pipe[0], pgid, output, cancel, limits, sink);
+    if (outcome) *outcome = result;
+
+    if (healthy) healthy = recv_reply(w.sock, kind, value) && kind == 'E';
+    w.jobs++;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs++;
+    }
+    release(w, healthy);
+    return true;
+}
+
+std::string ZygotePool::statsJson() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return "{\"available\":" + std::string(ctl >= 0 ? "true" : "false") +
+           ",\"warm\":" + std::to_string(warm) +
+           ",\"idle\":" + std::to_string(idle.size()) +
+           ",\"max_jobs\":" + std::to_string(max_jobs) +
+           ",\"jobs\":" + std::to_string(jobs) +
+           ",\"spawned\":" + std::to_string(spawned) +
+           ",\"recycled\":" + std::to_string(recycled) +
+           ",\"failed\":" + std::to_string(failed) + "}";
+}
@@ -1,7 +1,464 @@
 #include "utils/http.hpp"
 #include "utils/logger.hpp"
+#include "utils/cancel.hpp"
 #include <curl/curl.h>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <memory>
+#include <set>
+#include <thread>
+#include <chrono>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+
+const size_t MAX_IDLE_PER_HOST = 4;
+
+// "https://host:port/path?q" -> "https://host:port"
+std::string host_of(const std::string& url) {
+    size_t scheme = url.find("://");
+    size_t start = (scheme == std::string::npos) ? 0 : scheme + 3;
+    size_t end = url.find_first_of("/?#", start);
+    return url.substr(0, end);
+}
+
+class HandlePool {
+public:
+    static HandlePool& instance() {
+        static HandlePool pool;
+        return pool;
+    }
+
+    /// A handle for host with the shared caches attached; nullptr on failure
+    CURL* acquire(const std::string& host) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& free_handles = idle[host];
+        if (!free_handles.empty()) {
+            CURL* curl = free_handles.back();
+            free_handles.pop_back();
+            return curl;
+        }
+        CURL* curl = curl_easy_init();
+        if (curl) handles++;
+        return curl;
+    }
+
+    /// Account for the finished request and keep the handle for the next one
+    void release(const std::string& host, CURL* curl) {
+        long new_connections = 0, version = 0, status = 0;
+        curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &new_connections);
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+        curl_easy_getinfo(curl, CURLINFO_HTTP_VERSION, &version);
+        // Options go back to their defaults; connections and caches stay
+        curl_easy_reset(curl);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        HostStats& stats = hosts[host];
+        stats.requests++;
+        stats.connections += new_connections;
+        total.requests++;
+        total.connections += new_connections;
+        if (new_connections == 0 && status != 0) reused++;
+        if (version == CURL_HTTP_VERSION_2_0) http2++;
+
+        auto& free_handles = idle[host];
+        if (free_handles.size() < MAX_IDLE_PER_HOST) {
+            free_handles.push_back(curl);
+        } else {
+            curl_easy_cleanup(curl);
+            handles--;
+        }
+    }
+
+    /// Options every pooled request starts with. A streamed request has no
+    /// total timeout; it fails after that long without data instead.
+    void prepare(CURL* curl, const std::string& url, const std::string& data, bool streamed) {
+        long total_ms;
+        long connect_ms;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            total_ms = total_timeout_ms;
+            connect_ms = connect_timeout_ms;
+        }
+        curl_easy_setopt(curl, CURLOPT_SHARE, share);
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)data.length());
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, json_headers);
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, connect_ms);
+        if (streamed) {
+            long stall_s = total_ms / 1000;
+            curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+            curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, stall_s > 0 ? stall_s : 1L);
+        } else {
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, total_ms);
+        }
+    }
+
+    void setTimeouts(long connect_ms, long total_ms) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (connect_ms > 0) connect_timeout_ms = connect_ms;
+        if (total_ms > 0) total_timeout_ms = total_ms;
+    }
+
+    std::string statsJson() {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t idle_count = 0;
+        for (const auto& entry : idle) idle_count += entry.second.size();
+        std::string out = "{\"requests\":" + std::to_string(total.requests) +
+                          ",\"connections\":" + std::to_string(total.connections) +
+                          ",\"reused\":" + std::to_string(reused) +
+                          ",\"http2\":" + std::to_string(http2) +
+                          ",\"handles\":" + std::to_string(handles) +
+                          ",\"idle\":" + std::to_string(idle_count) + ",\"hosts\":{";
+        bool first = true;
+        for (const auto& entry : hosts) {
+            out += (first ? "\"" : ",\"") + entry.first + "\":{\"requests\":" + std::to_string(entry.second.requests) +
+                   ",\"connections\":" + std::to_string(entry.second.connections) + "}";
+            first = false;
+        }
+        return out + "}}";
+    }
+
+    void closeAll() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& entry : idle) {
+            for (CURL* curl : entry.second) curl_easy_cleanup(curl);
+            handles -= entry.second.size();
+            entry.second.clear();
+        }
+        if (share) curl_share_cleanup(share);
+        share = nullptr;
+        curl_slist_free_all(json_headers);
+        json_headers = nullptr;
+    }
+
+private:
+    struct HostStats {
+        uint64_t requests = 0;
+        uint64_t connections = 0;   // new TCP connections opened
+    };
+
+    std::mutex mutex;                  // guards everything below except the share's own locks
+    CURLSH* share = nullptr;
+    std::mutex share_locks[CURL_LOCK_DATA_LAST];
+    struct curl_slist* json_headers = nullptr;
+    std::map<std::string, std::vector<CURL*>> idle;
+    std::map<std::string, HostStats> hosts;
+    HostStats total;
+    uint64_t reused = 0;
+    uint64_t http2 = 0;
+    uint64_t handles = 0;
+    long connect_timeout_ms = 10000;
+    long total_timeout_ms = 120000;
+
+    HandlePool() {
+        json_headers = curl_slist_append(nullptr, "Content-Type: application/json");
+        share = curl_share_init();
+        if (!share) return;
+        curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lock_share);
+        curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlock_share);
+        curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+
+    static void lock_share(CURL*, curl_lock_data data, curl_lock_access, void* userp) {
+        static_cast<HandlePool*>(userp)->share_locks[data].lock();
+    }
+
+    static void unlock_share(CURL*, curl_lock_data data, void* userp) {
+        static_cast<HandlePool*>(userp)->share_locks[data].unlock();
+    }
+};
+
+// One in-flight async request
+struct Transfer {
+    HTTPClient::RequestId id = 0;
+    std::string host;
+    std::string url;
+    std::string data;                     // curl reads POSTFIELDS from here
+    CURL* curl = nullptr;
+    HTTPClient::DoneHandler on_done;
+    HTTPClient::ChunkHandler on_chunk;
+    HTTPClient::Response response;
+    bool cancelled = false;
+};
+
+// The curl multi handle and its event loop thread. Every curl_multi_* call
+// happens on that thread; other threads hand it work through the queues
+// below and an eventfd that wakes its epoll_wait.
+class AsyncEngine {
+public:
+    static AsyncEngine& instance() {
+        static AsyncEngine engine;
+        return engine;
+    }
+
+    HTTPClient::RequestId submit(std::unique_ptr<Transfer> transfer) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) start();
+        transfer->id = ++last_id;
+        HTTPClient::RequestId id = transfer->id;
+        live.insert(id);
+        incoming.push_back(std::move(transfer));
+        wake();
+        return id;
+    }
+
+    bool cancel(HTTPClient::RequestId id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!live.count(id)) return false;
+        cancels.push_back(id);
+        wake();
+        return true;
+    }
+
+    /// Cancel everything in flight and join the loop thread
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!running) return;
+            stopping = true;
+            wake();
+        }
+        loop.join();
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+        stopping = false;
+    }
+
+    ~AsyncEngine() {
+        stop();
+    }
+
+private:
+    std::mutex mutex;                     // guards the fields down to wake_fd
+    bool running = false;
+    bool stopping = false;
+    HTTPClient::RequestId last_id = 0;
+    std::set<HTTPClient::RequestId> live;  // submitted and not yet completed
+    std::vector<std::unique_ptr<Transfer>> incoming;
+    std::vector<HTTPClient::RequestId> cancels;
+    int wake_fd = -1;
+    std::thread loop;
+
+    // Loop thread only
+    CURLM* multi = nullptr;
+    int epoll_fd = -1;
+    bool timer_set = false;               // curl's timer
+    std::chrono::steady_clock::time_point deadline;
+    std::map<HTTPClient::RequestId, std::unique_ptr<Transfer>> active;
+
+    AsyncEngine() {
+        // The pool must outlive the engine's handles
+        HandlePool::instance();
+    }
+
+    void wake() {
+        uint64_t one = 1;
+        ssize_t n = write(wake_fd, &one, sizeof(one));
+        (void)n;
+    }
+
+    void start() {
+        multi = curl_multi_init();
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = wake_fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev);
+
+        curl_multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, on_socket);
+        curl_multi_setopt(multi, CURLMOPT_SOCKETDATA, this);
+        curl_multi_setopt(multi, CURLMOPT_TIMERFUNCTION, on_timer);
+        curl_multi_setopt(multi, CURLMOPT_TIMERDATA, this);
+        curl_multi_setopt(multi, CURLMOPT_PIPELINING, (long)CURLPIPE_MULTIPLEX);
+
+        running = true;
+        loop = std::thread(&AsyncEngine::run, this);
+    }
+
+    // curl: watch (or stop watching) s for what
+    static int on_socket(CURL*, curl_socket_t s, int what, void* userp, void*) {
+        AsyncEngine* self = static_cast<AsyncEngine*>(userp);
+        if (what == CURL_POLL_REMOVE) {
+            epoll_ctl(self->epoll_fd, EPOLL_CTL_DEL, s, nullptr);
+            return 0;
+        }
+        struct epoll_event ev = {};
+        ev.data.fd = s;
+        if (what & CURL_POLL_IN) ev.events |= EPOLLIN;
+        if (what & CURL_POLL_OUT) ev.events |= EPOLLOUT;
+        if (epoll_ctl(self->epoll_fd, EPOLL_CTL_MOD, s, &ev) != 0) {
+            epoll_ctl(self->epoll_fd, EPOLL_CTL_ADD, s, &ev);
+        }
+        return 0;
+    }
+
+    // curl: call socket_action(CURL_SOCKET_TIMEOUT) in timeout ms
+    static int on_timer(CURLM*, long timeout, void* userp) {
+        AsyncEngine* self = static_cast<AsyncEngine*>(userp);
+        self->timer_set = timeout >= 0;
+        self->deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+        return 0;
+    }
+
+    static size_t on_body(void* contents, size_t size, size_t nmemb, void* userp) {
+        Transfer* t = static_cast<Transfer*>(userp);
+        size_t len = size * nmemb;
+        if (!t->on_chunk) {
+            t->response.body.append((const char*)contents, len);
+            return len;
+        }
+        // Anything but the full size makes curl abort the transfer
+        return t->on_chunk((const char*)contents, len) ? len : 0;
+    }
+
+    void run() {
+        std::vector<struct epoll_event> events(64);
+        int still_running = 0;
+        while (true) {
+            if (!take_work()) break;
+
+            int wait_ms = -1;
+            if (timer_set) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now()).count();
+                wait_ms = left > 0 ? (int)left : 0;
+            }
+            int n = epoll_wait(epoll_fd, events.data(), (int)events.size(), wait_ms);
+            if (n < 0 && errno != EINTR) {
+                utils::Logger::error("HTTP event loop: epoll_wait failed: " + std::string(strerror(errno)));
+                break;
+            }
+            for (int i = 0; i < n; i++) {
+                int fd = events[i].data.fd;
+                if (fd == wake_fd) {
+                    uint64_t count;
+                    ssize_t r = read(wake_fd, &count, sizeof(count));
+                    (void)r;
+                    continue;
+                }
+                int flags = 0;
+                if (events[i].events & EPOLLIN) flags |= CURL_CSELECT_IN;
+                if (events[i].events & EPOLLOUT) flags |= CURL_CSELECT_OUT;
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) flags |= CURL_CSELECT_ERR;
+                curl_multi_socket_action(multi, fd, flags, &still_running);
+            }
+            if (timer_set && std::chrono::steady_clock::now() >= deadline) {
+                timer_set = false;
+                curl_multi_socket_action(multi, CURL_SOCKET_TIMEOUT, 0, &still_running);
+            }
+            finish_done();
+        }
+
+        // Shutting down: whatever is left ends as cancelled
+        for (auto& entry : active) entry.second->cancelled = true;
+        while (!active.empty()) complete(active.begin()->first, CURLE_OK);
+        std::vector<std::unique_ptr<Transfer>> never_started;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            never_started.swap(incoming);
+        }
+        for (auto& t : never_started) {
+            t->response.error = "cancelled";
+            if (t->on_done) t->on_done(t->response);
+        }
+        curl_multi_cleanup(multi);
+        multi = nullptr;
+        close(epoll_fd);
+        close(wake_fd);
+        epoll_fd = wake_fd = -1;
+    }
+
+    /// Start new transfers and apply cancels; false once stop() was called
+    bool take_work() {
+        std::vector<std::unique_ptr<Transfer>> added;
+        std::vector<HTTPClient::RequestId> cancelled;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) return false;
+            added.swap(incoming);
+            cancelled.swap(cancels);
+        }
+        HandlePool& pool = HandlePool::instance();
+        for (auto& t : added) {
+            t->curl = pool.acquire(t->host);
+            if (!t->curl) {
+                t->response.error = "out of curl handles";
+                forget(t->id);
+                if (t->on_done) t->on_done(t->response);
+                continue;
+            }
+            pool.prepare(t->curl, t->url, t->data, (bool)t->on_chunk);
+            curl_easy_setopt(t->curl, CURLOPT_WRITEFUNCTION, on_body);
+            curl_easy_setopt(t->curl, CURLOPT_WRITEDATA, t.get());
+            curl_easy_setopt(t->curl, CURLOPT_PRIVATE, t.get());
+            curl_multi_add_handle(multi, t->curl);
+            active[t->id] = std::move(t);
+        }
+        for (HTTPClient::RequestId id : cancelled) {
+            auto it = active.find(id);
+            if (it == active.end()) continue;
+            it->second->cancelled = true;
+            complete(id, CURLE_OK);
+        }
+        return true;
+    }
+
+    void finish_done() {
+        int queued = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi, &queued)) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            Transfer* t = nullptr;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&t);
+            if (t) complete(t->id, msg->data.result);
+        }
+    }
+
+    void complete(HTTPClient::RequestId id, CURLcode result) {
+        auto it = active.find(id);
+        std::unique_ptr<Transfer> t = std::move(it->second);
+        active.erase(it);
+
+        curl_easy_getinfo(t->curl, CURLINFO_RESPONSE_CODE, &t->response.status);
+        curl_off_t total_us = 0;
+        curl_easy_getinfo(t->curl, CURLINFO_TOTAL_TIME_T, &total_us);
+        t->response.total_ms = (long)(total_us / 1000);
+        curl_multi_remove_handle(multi, t->curl);
+        if (t->cancelled) {
+            t->response.error = "cancelled";
+        } else if (result == CURLE_WRITE_ERROR && t->on_chunk) {
+            t->response.error = "aborted";
+        } else if (result != CURLE_OK) {
+            t->response.error = curl_easy_strerror(result);
+            utils::Logger::error("async POST " + t->url.substr(0, t->url.find('?')) + " failed: " + t->response.error);
+        }
+        HandlePool::instance().release(t->host, t->curl);
+        forget(id);
+        if (t->on_done) t->on_done(t->response);
+    }
+
+    void forget(HTTPClient::RequestId id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        live.erase(id);
+    }
+};
+
+} // namespace
 
 size_t HTTPClient::write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
     ((std::string*)userp)->append((char*)contents, size * nmemb);
@@ -9,31 +466,110 @@ size_t HTTPClient::write_callback(void* contents, size_t size, size_t nmemb, voi
 }
 
 std::string HTTPClient::post(const std::string& url, const std::string& data) {
-    CURL* curl = curl_easy_init();
+    HandlePool& pool = HandlePool::instance();
+    std::string host = host_of(url);
+    CURL* curl = pool.acquire(host);
     std::string response;
-    
+
     if (curl) {
-        struct curl_slist* headers = nullptr;
-        headers = curl_slist_append(headers, "Content-Type: application/json");
-        
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        pool.prepare(curl, url, data, false);
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 120L);
-        
+
         CURLcode res = curl_easy_perform(curl);
-        
+
         if (res != CURLE_OK) {
             std::string err = curl_easy_strerror(res);
             std::cerr << "curl_easy_perform() failed: " << err << std::endl;
             utils::Logger::error("curl_easy_perform() failed: " + err);
         }
-        
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
+
+        pool.release(host, curl);
     }
-    
+
     return response;
 }
+
+size_t HTTPClient::stream_callback(void* contents, size_t size, size_t nmemb, void* userp) {
+    const ChunkHandler& on_chunk = *(const ChunkHandler*)userp;
+    // Anything but the full size makes curl abort the transfer
+    return on_chunk((const char*)contents, size * nmemb) ? size * nmemb : 0;
+}
+
+bool HTTPClient::postStream(const std::string& url, const std::string& data, const ChunkHandler& on_chunk) {
+    HandlePool& pool = HandlePool::instance();
+    std::string host = host_of(url);
+    CURL* curl = pool.acquire(host);
+    if (!curl) return false;
+
+    pool.prepare(curl, url, data, true);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, stream_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &on_chunk);
+
+    CURLcode res = curl_easy_perform(curl);
+    if (res != CURLE_OK && res != CURLE_WRITE_ERROR) {
+        std::string err = curl_easy_strerror(res);
+        std::cerr << "curl_easy_perform() failed: " << err << std::endl;
+        utils::Logger::error("curl_easy_perform() failed: " + err);
+    }
+
+    pool.release(host, curl);
+    return res == CURLE_OK;
+}
+
+void HTTPClient::setTimeouts(long connect_ms, long total_ms) {
+    HandlePool::instance().setTimeouts(connect_ms, total_ms);
+}
+
+std::string HTTPClient::statsJson() {
+    return HandlePool::instance().statsJson();
+}
+
+HTTPClient::RequestId HTTPClient::postAsync(const std::string& url, const std::string& data,
+                                            DoneHandler on_done, ChunkHandler on_chunk) {
+    auto transfer = std::make_unique<Transfer>();
+    transfer->host = host_of(url);
+    transfer->url = url;
+    transfer->data = data;
+    transfer->on_done = std::move(on_done);
+    transfer->on_chunk = std::move(on_chunk);
+    return AsyncEngine::instance().submit(std::move(transfer));
+}
+
+std::future<HTTPClient::Response> HTTPClient::postFuture(const std::string& url, const std::string& data,
+                                                         RequestId* id) {
+    auto promise = std::make_shared<std::promise<Response>>();
+    std::future<Response> result = promise->get_future();
+    RequestId started = postAsync(url, data, [promise](const Response& response) {
+        promise->set_value(response);
+    });
+    if (id) *id = started;
+    return result;
+}
+
+std::vector<HTTPClient::Response> HTTPClient::postAll(const std::string& url, const std::vector<std::string>& bodies) {
+    std::vector<RequestId> ids(bodies.size());
+    std::vector<std::future<Response>> pending;
+    for (size_t i = 0; i < bodies.size(); i++) pending.push_back(postFuture(url, bodies[i], &ids[i]));
+
+    std::vector<Response> responses;
+    bool cancelled = false;
+    for (size_t i = 0; i < pending.size(); i++) {
+        while (pending[i].wait_for(std::chrono::milliseconds(50)) != std::future_status::ready) {
+            if (cancelled || !utils::CancelScope::requested()) continue;
+            for (RequestId id : ids) cancel(id);
+            cancelled = true;
+        }
+        responses.push_back(pending[i].get());
+    }
+    return responses;
+}
+
+bool HTTPClient::cancel(RequestId id) {
+    return AsyncEngine::instance().cancel(id);
+}
+
+void HTTPClient::closeAll() {
+    AsyncEngine::instance().stop();
+    HandlePool::instance().closeAll();
+}
@@ -225,5 +225,94 @@ std::vector<std::string> get_string_array(const std::string& json, const std::st
     return result;
 }
 
+// Index just past the raw JSON value starting at pos (string, number,
+// literal, object or array), with strings skipped so braces inside them
+// do not count.
+static size_t skip_value(const std::string& json, size_t pos) {
+    if (pos >= json.length()) return pos;
+    if (json[pos] == '"') {
+        for (pos++; pos < json.length(); pos++) {
+            if (json[pos] == '\\') pos++;
+            else if (json[pos] == '"') return pos + 1;
+        }
+        return pos;
+    }
+    if (json[pos] == '{' || json[pos] == '[') {
+        int depth = 0;
+        for (; pos < json.length(); pos++) {
+            char c = json[pos];
+            if (c == '"') {
+                pos = skip_value(json, pos) - 1;
+            } else if (c == '{' || c == '[') {
+                depth++;
+            } else if ((c == '}' || c == ']') && --depth == 0) {
+                return pos + 1;
+            }
+        }
+        return pos;
+    }
+    while (pos < json.length() && json[pos] != ',' && json[pos] != '}' && json[pos] != ']' &&
+           !std::isspace((unsigned char)json[pos])) pos++;
+    return pos;
+}
+
+static size_t skip_ws(const std::string& json, size_t pos) {
+    while (pos < json.length() && std::isspace((unsigned char)json[pos])) pos++;
+    return pos;
+}
+
+std::vector<std::pair<std::string, std::string>> members(const std::string& json) {
+    std::vector<std::pair<std::string, std::string>> result;
+    size_t pos = skip_ws(json, 0);
+    if (pos >= json.length() || json[pos] != '{') return result;
+    pos++;
+    
+    while (true) {
+        pos = skip_ws(json, pos);
+        if (pos >= json.length() || json[pos] != '"') break;
+        size_t key_end = skip_value(json, pos);
+        std::string key = unescape(json.substr(pos + 1, key_end - pos - 2));
+        
+        pos = skip_ws(json, key_end);
+        if (pos >= json.length() || json[pos] != ':') break;
+        pos = skip_ws(json, pos + 1);
+        
+        size_t value_end = skip_value(json, pos);
+        result.push_back({key, json.substr(pos, value_end - pos)});
+        
+        pos = skip_ws(json, value_end);
+        if (pos >= json.length() || json[pos] != ',') break;
+        pos++;
+    }
+    return result;
+}
+
+std::vector<std::string> items(const std::string& json) {
+    std::vector<std::string> result;
+    size_t pos = skip_ws(json, 0);
+    if (pos >= json.length() || json[pos] != '[') return result;
+    pos++;
+    
+    while (true) {
+        pos = skip_ws(json, pos);
+        if (pos >= json.length() || json[pos] == ']') break;
+        size_t end = skip_value(json, pos);
+        if (end == pos) break;
+        result.push_back(json.substr(pos, end - pos));
+        
+        pos = skip_ws(json, end);
+        if (pos >= json.length() || json[pos] != ',') break;
+        pos++;
+    }
+    return result;
+}
+
+std::string scalar(const std::string& raw) {
+    if (raw.length() >= 2 && raw.front() == '"' && raw.back() == '"') {
+        return unescape(raw.substr(1, raw.length() - 2));
+    }
+    return raw;
+}
+
 } // namespace parse
 } // namespace json
@@ -4,26 +4,80 @@
 
 namespace term {
 
+static const int BOX_WIDTH = 80;
+
+static void box_top(const std::string& title, const std::string& color) {
+    std::cout << color << "╭" << repeat("─", 2) << "[ " << BOLD << title << RESET << color << " ]" << repeat("─", BOX_WIDTH - (int)title.length() - 7) << "╮" << RESET << "\n";
+}
+
+static void box_line(std::string line, const std::string& color) {
+    int inner_width = BOX_WIDTH - 4;
+    while (line.length() > (size_t)inner_width) {
+        size_t pos = line.find_last_of(" \t", inner_width);
+        if (pos == std::string::npos) pos = inner_width;
+        
+        std::string part = line.substr(0, pos);
+        std::cout << color << "│ " << RESET << part << std::string(inner_width - part.length(), ' ') << color << " │" << RESET << "\n";
+        line = line.substr(pos == inner_width ? pos : pos + 1);
+    }
+    std::cout << color << "│ " << RESET << line << std::string(inner_width - line.length(), ' ') << color << " │" << RESET << "\n";
+}
+
+static void box_bottom(const std::string& color) {
+    std::cout << color << "╰" << repeat("─", BOX_WIDTH - 2) << "╯" << RESET << "\n";
+}
+
 void draw_box(const std::string& title, const std::string& content, const std::string& color) {
-    int width = 80;
-    int inner_width = width - 4;
-    std::cout << color << "╭" << repeat("─", 2) << "[ " << BOLD << title << RESET << color << " ]" << repeat("─", width - (int)title.length() - 7) << "╮" << RESET << "\n";
+    box_top(title, color);
     
     std::stringstream ss(content);
     std::string line;
-    while (std::getline(ss, line)) {
-        while (line.length() > (size_t)inner_width) {
-            size_t pos = line.find_last_of(" \t", inner_width);
+    while (std::getline(ss, line)) box_line(line, color);
+    
+    box_bottom(color);
+}
+
+void LiveBox::write(const std::string& text) {
+    if (is_closed) return;
+    if (!is_open) {
+        box_top(title, color);
+        is_open = true;
+    }
+    pending += text;
+    size_t start = 0, nl;
+    while ((nl = pending.find('\n', start)) != std::string::npos) {
+        // A full row overwrites the partial one shown for it
+        if (partial_shown) std::cout << "\r";
+        partial_shown = false;
+        box_line(pending.substr(start, nl - start), color);
+        start = nl + 1;
+    }
+    pending.erase(0, start);
+    if (show_partial && !pending.empty()) {
+        // Rows that are already full wrap as box_line() would wrap them
+        int inner_width = BOX_WIDTH - 4;
+        while (pending.length() > (size_t)inner_width) {
+            size_t pos = pending.find_last_of(" \t", inner_width);
             if (pos == std::string::npos) pos = inner_width;
-            
-            std::string part = line.substr(0, pos);
-            std::cout << color << "│ " << RESET << part << std::string(inner_width - part.length(), ' ') << color << " │" << RESET << "\n";
-            line = line.substr(pos == inner_width ? pos : pos + 1);
+            if (partial_shown) std::cout << "\r";
+            box_line(pending.substr(0, pos), color);
+            pending.erase(0, pos == (size_t)inner_width ? pos : pos + 1);
         }
-        std::cout << color << "│ " << RESET << line << std::string(inner_width - line.length(), ' ') << color << " │" << RESET << "\n";
+        std::cout << "\r" << color << "│ " << RESET << pending;
+        partial_shown = true;
     }
-    
-    std::cout << color << "╰" << repeat("─", width - 2) << "╯" << RESET << "\n";
+    std::cout.flush();
+}
+
+void LiveBox::close() {
+    if (!is_open || is_closed) return;
+    if (partial_shown) std::cout << "\r";
+    partial_shown = false;
+    if (!pending.empty()) box_line(pending, color);
+    pending.clear();
+    box_bottom(color);
+    is_open = false;
+    is_closed = true;
 }
 
 void print_thought(const std::string& thought) {
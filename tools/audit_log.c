@@ -0,0 +1,307 @@
+#include "audit_log.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+
+#define DEFAULT_MAX_MB 16
+#define DEFAULT_MAX_AGE_H 168
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t file_lock = PTHREAD_MUTEX_INITIALIZER;   // held around commit() in async mode
+static pthread_cond_t work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done = PTHREAD_COND_INITIALIZER;
+
+// Current file; all guarded by lock, or owned by the writer thread once it runs
+static int fd = -1;
+static dev_t file_dev;
+static ino_t file_ino;
+static off_t file_size;
+static int64_t first_us;         // time of the file's first record, 0 if empty
+static off_t max_bytes;
+static int64_t max_age_us;
+static char user_name[32] = "unknown";
+static int configured;
+
+// Group commit queue. Records are numbered in queue order; committed is
+// the number of the last one written and synced.
+static int async_mode;
+static AuditRecord *queue;
+static size_t queued, queue_cap;
+static uint64_t enqueued, committed;
+
+static atomic_uint_fast64_t total_records, total_batches, total_rotations;
+
+static int64_t now_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void configure(void) {
+    if (configured) return;
+    configured = 1;
+    const char *mb = getenv("OLLMCPC_AUDIT_MAX_MB");
+    const char *hours = getenv("OLLMCPC_AUDIT_MAX_AGE_H");
+    max_bytes = (off_t)(mb ? atol(mb) : DEFAULT_MAX_MB) * 1024 * 1024;
+    max_age_us = (int64_t)(hours ? atol(hours) : DEFAULT_MAX_AGE_H) * 3600 * 1000000;
+    const char *user = getenv("USER");
+    if (user) snprintf(user_name, sizeof(user_name), "%s", user);
+}
+
+static void open_file(void) {
+    fd = open(AUDIT_FILE, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return;
+    struct stat st;
+    fstat(fd, &st);
+    file_dev = st.st_dev;
+    file_ino = st.st_ino;
+    file_size = st.st_size;
+    first_us = 0;
+    if (file_size >= (off_t)sizeof(AuditRecord)) {
+        int rfd = open(AUDIT_FILE, O_RDONLY | O_CLOEXEC);
+        AuditRecord first;
+        if (rfd >= 0 && pread(rfd, &first, sizeof(first), 0) == (ssize_t)sizeof(first) &&
+            first.magic == AUDIT_MAGIC) {
+            first_us = first.time_us;
+        }
+        if (rfd >= 0) close(rfd);
+    }
+}
+
+// Move the full (or old, or damaged) file aside as a segment; the flock
+// keeps two writers from rotating the same file twice
+static void rotate(void) {
+    flock(fd, LOCK_EX);
+    struct stat cur;
+    if (stat(AUDIT_FILE, &cur) == 0 && cur.st_dev == file_dev && cur.st_ino == file_ino) {
+        time_t t = time(NULL);
+        struct tm tm;
+        gmtime_r(&t, &tm);
+        char stamp[32], segment[96];
+        strftime(stamp, sizeof(stamp), "%Y%m%dT%H%M%SZ", &tm);
+        snprintf(segment, sizeof(segment), AUDIT_SEGMENT_PREFIX "%s.bin", stamp);
+        for (int n = 1; link(AUDIT_FILE, segment) < 0 && errno == EEXIST && n < 100; n++) {
+            snprintf(segment, sizeof(segment), AUDIT_SEGMENT_PREFIX "%s-%d.bin", stamp, n);
+        }
+        unlink(AUDIT_FILE);
+        total_rotations++;
+    }
+    flock(fd, LOCK_UN);
+    close(fd);
+    open_file();
+}
+
+// Reopen if another writer rotated, rotate if due
+static void prepare(void) {
+    configure();
+    if (fd >= 0) {
+        struct stat cur;
+        if (stat(AUDIT_FILE, &cur) != 0 || cur.st_dev != file_dev || cur.st_ino != file_ino) {
+            close(fd);
+            fd = -1;
+        } else {
+            file_size = cur.st_size;
+        }
+    }
+    if (fd < 0) open_file();
+    if (fd < 0) return;
+    if (file_size % (off_t)sizeof(AuditRecord) != 0 ||
+        (max_bytes > 0 && file_size >= max_bytes) ||
+        (max_age_us > 0 && first_us > 0 && now_us() - first_us > max_age_us)) {
+        rotate();
+    }
+}
+
+static void commit(const AuditRecord *recs, size_t count, int sync) {
+    prepare();
+    if (fd < 0) return;
+    // One write per batch: O_APPEND keeps concurrent writers from interleaving
+    size_t len = count * sizeof(AuditRecord);
+    ssize_t written = write(fd, recs, len);
+    if (written > 0) {
+        if (first_us == 0) first_us = recs[0].time_us;
+        file_size += written;
+    }
+    if (sync) fdatasync(fd);
+    total_records += count;
+    total_batches++;
+}
+
+static void *writer_main(void *arg) {
+    (void)arg;
+    AuditRecord *batch = NULL;
+    size_t batch_cap = 0;
+    pthread_mutex_lock(&lock);
+    while (1) {
+        while (queued == 0) pthread_cond_wait(&work, &lock);
+        // Take everything queued so far; callers keep queueing meanwhile
+        if (batch_cap < queued) {
+            free(batch);
+            batch_cap = queue_cap;
+            batch = malloc(batch_cap * sizeof(AuditRecord));
+            if (!batch) batch_cap = 0;
+        }
+        size_t count = queued;
+        if (!batch) {
+            // No copy to work from: commit straight from the queue, holding it
+            pthread_mutex_lock(&file_lock);
+            commit(queue, count, 1);
+            pthread_mutex_unlock(&file_lock);
+            queued = 0;
+        } else {
+            memcpy(batch, queue, count * sizeof(AuditRecord));
+            queued = 0;
+            pthread_mutex_unlock(&lock);
+
+            pthread_mutex_lock(&file_lock);
+            commit(batch, count, 1);
+            pthread_mutex_unlock(&file_lock);
+
+            pthread_mutex_lock(&lock);
+        }
+        committed += count;
+        pthread_cond_broadcast(&done);
+    }
+    return NULL;
+}
+
+void audit_start_writer(void) {
+    pthread_mutex_lock(&lock);
+    if (!async_mode) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, writer_main, NULL) == 0) {
+            pthread_detach(thread);
+            async_mode = 1;
+            atexit(audit_flush);
+        }
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+void audit_open(void) {
+    pthread_mutex_lock(&lock);
+    prepare();
+    pthread_mutex_unlock(&lock);
+}
+
+void audit_append(const AuditRecord *rec) {
+    pthread_mutex_lock(&lock);
+    if (!async_mode) {
+        commit(rec, 1, 0);
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+    if (queued == queue_cap) {
+        size_t cap = queue_cap ? queue_cap * 2 : 64;
+        AuditRecord *grown = realloc(queue, cap * sizeof(AuditRecord));
+        if (!grown) {
+            // No room to queue it: write it ourselves, synced, before returning
+            pthread_mutex_unlock(&lock);
+            pthread_mutex_lock(&file_lock);
+            commit(rec, 1, 1);
+            pthread_mutex_unlock(&file_lock);
+            return;
+        }
+        queue = grown;
+        queue_cap = cap;
+    }
+    queue[queued++] = *rec;
+    uint64_t seq = ++enqueued;
+    pthread_cond_signal(&work);
+    // Callers share the batch's write and fdatasync, but none goes on (to
+    // exec the command) before its own record is on disk
+    while (committed < seq) pthread_cond_wait(&done, &lock);
+    pthread_mutex_unlock(&lock);
+}
+
+void audit_flush(void) {
+    pthread_mutex_lock(&lock);
+    uint64_t target = enqueued;
+    while (async_mode && committed < target) pthread_cond_wait(&done, &lock);
+    pthread_mutex_unlock(&lock);
+}
+
+void audit_counters(uint64_t *records, uint64_t *batches, uint64_t *rotations) {
+    *records = atomic_load(&total_records);
+    *batches = atomic_load(&total_batches);
+    *rotations = atomic_load(&total_rotations);
+}
+
+static uint8_t status_code(const char *status) {
+    if (strcmp(status, "ALLOWED") == 0) return AUDIT_ALLOWED;
+    if (strcmp(status, "DENIED") == 0) return AUDIT_DENIED;
+    if (strcmp(status, "ABORTED") == 0) return AUDIT_ABORTED;
+    if (strcmp(status, "SUBMITTED") == 0) return AUDIT_SUBMITTED;
+    return AUDIT_OTHER;
+}
+
+const char *audit_status_name(uint8_t status) {
+    switch (status) {
+        case AUDIT_ALLOWED: return "ALLOWED";
+        case AUDIT_DENIED: return "DENIED";
+        case AUDIT_ABORTED: return "ABORTED";
+        case AUDIT_SUBMITTED: return "SUBMITTED";
+        default: return "OTHER";
+    }
+}
+
+// Copy src into a NUL-padded field; returns 1 if it had to be cut
+static int copy_field(char *field, size_t size, const char *src) {
+    size_t len = strlen(src);
+    int cut = len >= size;
+    if (cut) len = size - 1;
+    memcpy(field, src, len);
+    memset(field + len, 0, size - len);
+    return cut;
+}
+
+void audit_record(AuditRecord *rec, const char *cmd_name, const char *status, const char *details) {
+    pthread_mutex_lock(&lock);
+    configure();
+    pthread_mutex_unlock(&lock);
+    memset(rec, 0, sizeof(*rec));
+    rec->magic = AUDIT_MAGIC;
+    rec->version = AUDIT_VERSION;
+    rec->status = status_code(status);
+    rec->time_us = now_us();
+    rec->pid = (uint32_t)getpid();
+    rec->uid = (uint32_t)getuid();
+    copy_field(rec->user, sizeof(rec->user), user_name);
+    if (copy_field(rec->details, sizeof(rec->details), details)) rec->flags |= AUDIT_TRUNCATED;
+    if (copy_field(rec->cmd, sizeof(rec->cmd), cmd_name)) rec->flags |= AUDIT_TRUNCATED;
+}
+
+void audit_format(const AuditRecord *rec, char *buf, size_t len) {
+    time_t t = (time_t)(rec->time_us / 1000000);
+    char date[32];
+    ctime_r(&t, date);
+    date[strlen(date) - 1] = '\0';
+    snprintf(buf, len, "[%s] USER:%.32s CMD:%.160s STATUS:%s MSG:%.40s\n",
+             date, rec->user, rec->cmd, audit_status_name(rec->status), rec->details);
+}
+
+long audit_export(FILE *out, const char *path) {
+    FILE *in = fopen(path, "rb");
+    if (!in) return -1;
+    AuditRecord rec;
+    char line[512];
+    long count = 0;
+    while (fread(&rec, sizeof(rec), 1, in) == 1) {
+        if (rec.magic != AUDIT_MAGIC) continue;   // damaged slot
+        audit_format(&rec, line, sizeof(line));
+        fputs(line, out);
+        count++;
+    }
+    fclose(in);
+    return count;
+}
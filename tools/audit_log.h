@@ -0,0 +1,100 @@
+#ifndef AUDIT_LOG_H
+#define AUDIT_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * Binary audit log, written by dispatch_policy.c (policy_audit).
+ *
+ * Records are fixed 256-byte structs in host byte order, appended to
+ * AUDIT_FILE in the working directory with O_APPEND, so concurrent writers
+ * (mcp_server, zygote workers, manual dispatcher runs) never interleave.
+ * The file is rotated into a time-ordered segment
+ *
+ *   system_audit-YYYYmmddTHHMMSSZ.bin   (UTC time of rotation)
+ *
+ * once it reaches OLLMCPC_AUDIT_MAX_MB (default 16) or its first record is
+ * older than OLLMCPC_AUDIT_MAX_AGE_H hours (default 168). Other writers
+ * notice the new inode and reopen.
+ *
+ * By default every record is one write() before the caller goes on, as the
+ * old text log was. audit_start_writer() switches the process to group
+ * commit: a writer thread appends all queued records with one write() and
+ * one fdatasync() per batch, and each caller waits until the batch holding
+ * its record is synced. Concurrent callers share the cost; none runs ahead
+ * of its record.
+ *
+ * "dispatcher --audit-export" prints the records in the old text format.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIT_FILE "system_audit.bin"
+#define AUDIT_SEGMENT_PREFIX "system_audit-"
+#define AUDIT_MAGIC 0x31445541u   /* "AUD1" */
+#define AUDIT_VERSION 1
+
+typedef enum {
+    AUDIT_ALLOWED = 0,
+    AUDIT_DENIED = 1,
+    AUDIT_ABORTED = 2,
+    AUDIT_SUBMITTED = 3,       /* a shell session command line, checked as it runs */
+    AUDIT_OTHER = 255
+} AuditStatus;
+
+#define AUDIT_TRUNCATED 0x01   /* cmd or details did not fit */
+
+typedef struct {
+    uint32_t magic;            /* AUDIT_MAGIC */
+    uint8_t version;           /* AUDIT_VERSION */
+    uint8_t status;            /* AuditStatus */
+    uint8_t flags;             /* AUDIT_TRUNCATED */
+    uint8_t reserved;
+    int64_t time_us;           /* wall clock, microseconds since the epoch */
+    uint32_t pid;
+    uint32_t uid;
+    char user[32];             /* NUL-padded, like the fields below */
+    char details[40];
+    char cmd[160];
+} AuditRecord;
+
+#ifndef __cplusplus
+_Static_assert(sizeof(AuditRecord) == 256, "AuditRecord must stay 256 bytes");
+#endif
+
+/* Fill a record stamped with the current time, pid, uid and user */
+void audit_record(AuditRecord *rec, const char *cmd_name, const char *status, const char *details);
+
+/* Open (or create) the log now instead of at the first append, so
+ * processes forked afterwards inherit the descriptor */
+void audit_open(void);
+
+/* Append one record; after audit_start_writer, returns once it is synced */
+void audit_append(const AuditRecord *rec);
+
+/* Switch this process to group commit; idempotent */
+void audit_start_writer(void);
+
+/* Wait until every record queued so far is written and synced */
+void audit_flush(void);
+
+/* Totals for this process */
+void audit_counters(uint64_t *records, uint64_t *batches, uint64_t *rotations);
+
+const char *audit_status_name(uint8_t status);
+
+/* The old text line: "[date] USER:.. CMD:.. STATUS:.. MSG:..\n" */
+void audit_format(const AuditRecord *rec, char *buf, size_t len);
+
+/* Print every record of path as text; returns the count, -1 if unreadable */
+long audit_export(FILE *out, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AUDIT_LOG_H */
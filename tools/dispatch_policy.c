@@ -0,0 +1,169 @@
+#include "dispatch_policy.h"
+#include "audit_log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <grp.h>
+#include <pwd.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#define ADMIN_GROUP "sudo"
+
+static const CommandMetadata policy_table[] = {
+    /* Internal commands */
+    {"sched", LVL_ADMIN, NULL, 1},
+    {"wipe",  LVL_DANGEROUS, "This clears system caches and logs.", 1},
+
+    /* Dangerous external binaries */
+    {"rm",       LVL_DANGEROUS, "This is a destructive system utility.", 0},
+    {"rmdir",    LVL_DANGEROUS, "This is a destructive system utility.", 0},
+    {"dd",       LVL_DANGEROUS, "This is a destructive system utility.", 0},
+    {"mkfs",     LVL_DANGEROUS, "This is a destructive system utility.", 0},
+    {"fdisk",    LVL_DANGEROUS, "This is a destructive system utility.", 0},
+    {"reboot",   LVL_DANGEROUS, "This is a destructive system utility.", 0},
+    {"shutdown", LVL_DANGEROUS, "This is a destructive system utility.", 0},
+    {"chmod",    LVL_DANGEROUS, "This is a destructive system utility.", 0},
+    {"chown",    LVL_DANGEROUS, "This is a destructive system utility.", 0},
+    {"run_shell_command.sh", LVL_DANGEROUS, "This is a destructive system utility.", 0},
+};
+
+static const char *const session_builtins[] = {"trap", "set", "shopt", "unset", "enable", "builtin"};
+
+#define POLICY_ENTRIES (sizeof(policy_table) / sizeof(policy_table[0]))
+#define POLICY_BUCKETS 64   /* power of two, well above POLICY_ENTRIES */
+
+/* Open addressing, linear probing; -1 = empty */
+static int buckets[POLICY_BUCKETS];
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+static int authorized = -1;   /* -1 until first needed */
+static pthread_mutex_t auth_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned int hash_name(const char *name) {
+    unsigned int h = 2166136261u;   /* FNV-1a */
+    for (; *name; name++) h = (h ^ (unsigned char)*name) * 16777619u;
+    return h;
+}
+
+static void init_tables(void) {
+    for (int i = 0; i < POLICY_BUCKETS; i++) buckets[i] = -1;
+    for (size_t i = 0; i < POLICY_ENTRIES; i++) {
+        unsigned int slot = hash_name(policy_table[i].name) & (POLICY_BUCKETS - 1);
+        while (buckets[slot] >= 0) slot = (slot + 1) & (POLICY_BUCKETS - 1);
+        buckets[slot] = (int)i;
+    }
+}
+
+void policy_init(void) {
+    pthread_once(&init_once, init_tables);
+}
+
+static const CommandMetadata *lookup(const char *name) {
+    unsigned int slot = hash_name(name) & (POLICY_BUCKETS - 1);
+    while (buckets[slot] >= 0) {
+        if (strcmp(policy_table[buckets[slot]].name, name) == 0) return &policy_table[buckets[slot]];
+        slot = (slot + 1) & (POLICY_BUCKETS - 1);
+    }
+    return NULL;
+}
+
+static int check_authorized(void) {
+    uid_t uid = getuid();
+    struct passwd pwd, *pw = NULL;
+    char buf[4096];
+    if (getpwuid_r(uid, &pwd, buf, sizeof(buf), &pw) != 0 || !pw) return 0;
+    if (uid == 0) return 1; // Root is always auth
+
+    int ngroups = 0;
+    getgrouplist(pw->pw_name, pw->pw_gid, NULL, &ngroups);
+    gid_t *groups = malloc(ngroups * sizeof(gid_t));
+    if (!groups) return 0;
+    getgrouplist(pw->pw_name, pw->pw_gid, groups, &ngroups);
+
+    struct group grp, *gr = NULL;
+    char gbuf[4096];
+    if (getgrnam_r(ADMIN_GROUP, &grp, gbuf, sizeof(gbuf), &gr) != 0 || !gr) { free(groups); return 0; }
+
+    int auth = 0;
+    for (int i = 0; i < ngroups; i++) {
+        if (groups[i] == gr->gr_gid) { auth = 1; break; }
+    }
+    free(groups);
+    return auth;
+}
+
+static int is_authorized_user(void) {
+    pthread_mutex_lock(&auth_mutex);
+    if (authorized < 0) authorized = check_authorized();
+    int auth = authorized;
+    pthread_mutex_unlock(&auth_mutex);
+    return auth;
+}
+
+PolicyVerdict policy_check(const char *cmd_name, int exec_dangerous, CommandMetadata *meta) {
+    policy_init();
+
+    // --- STEP 1: Identify Command Type ---
+    const CommandMetadata *listed = lookup(cmd_name);
+    if (listed) {
+        *meta = *listed;
+    } else {
+        // Not listed: an external Linux command, safe by default
+        meta->name = cmd_name;
+        meta->level = LVL_USER;
+        meta->warning_msg = NULL;
+        meta->is_internal = 0;
+    }
+
+    // --- STEP 2: Policy Enforcement (PDP) ---
+
+    // A. Check Permissions
+    if (meta->level >= LVL_ADMIN && !is_authorized_user()) {
+        policy_audit(cmd_name, "DENIED", "Unauthorized Group");
+        return POLICY_DENIED;
+    }
+
+    // B. Check Safety: dangerous commands need the user's approval (-y)
+    if (meta->level == LVL_DANGEROUS && !exec_dangerous) {
+        policy_audit(cmd_name, "ABORTED", "User declined warning");
+        return POLICY_ABORTED;
+    }
+    return POLICY_ALLOWED;
+}
+
+const char *policy_refusal(PolicyVerdict verdict, const char *cmd_name, char *buf, size_t len) {
+    switch (verdict) {
+        case POLICY_DENIED:
+            snprintf(buf, len, "PERMISSION DENIED: '%s' requires Admin privileges.\n", cmd_name);
+            break;
+        case POLICY_ABORTED:
+            snprintf(buf, len, "Operation Aborted.\n"
+                               "You either declined the operation or you were not asked for permission\n"
+                               "If you want to run the process activate HIL and give permission\n");
+            break;
+        default:
+            snprintf(buf, len, "%s", "");
+    }
+    return buf;
+}
+
+void policy_audit(const char *cmd_name, const char *status, const char *details) {
+    AuditRecord rec;
+    audit_record(&rec, cmd_name, status, details);
+    audit_append(&rec);
+}
+
+size_t policy_count(void) {
+    return POLICY_ENTRIES;
+}
+
+const CommandMetadata *policy_entry(size_t index) {
+    return index < POLICY_ENTRIES ? &policy_table[index] : NULL;
+}
+
+const char *policy_session_builtin(size_t index) {
+    return index < sizeof(session_builtins) / sizeof(session_builtins[0]) ? session_builtins[index] : NULL;
+}
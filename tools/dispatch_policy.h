@@ -0,0 +1,65 @@
+#ifndef DISPATCH_POLICY_H
+#define DISPATCH_POLICY_H
+
+#include <stddef.h>
+
+/*
+ * Dispatcher policy decision point, shared by the dispatcher CLI and
+ * mcp_server (which links it and calls it in-process).
+ *
+ * The command table is hashed once and the caller's admin status is looked
+ * up once (on the first command that needs it). Audit records go to the
+ * binary log in audit_log.c. All functions are thread-safe; state set up
+ * before fork() is inherited by the children.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    LVL_USER = 0,
+    LVL_ADMIN = 1,
+    LVL_DANGEROUS = 2
+} PrivilegeLevel;
+
+typedef struct {
+    const char *name;
+    PrivilegeLevel level;
+    const char *warning_msg;
+    int is_internal;    /* implemented inside the dispatcher (sched, wipe) */
+} CommandMetadata;
+
+typedef enum {
+    POLICY_ALLOWED = 0,
+    POLICY_DENIED,      /* admin level, caller not in ADMIN_GROUP */
+    POLICY_ABORTED      /* dangerous, and the user did not approve (-n) */
+} PolicyVerdict;
+
+/* Build the table. Optional: every other call does
+ * it on first use. Call before fork() to share the work with children. */
+void policy_init(void);
+
+/* Classify cmd_name into meta and decide. Refusals are audited here; the
+ * caller audits an allowed command when it actually runs it. */
+PolicyVerdict policy_check(const char *cmd_name, int exec_dangerous, CommandMetadata *meta);
+
+/* The text the dispatcher prints for a refusal ("" for POLICY_ALLOWED) */
+const char *policy_refusal(PolicyVerdict verdict, const char *cmd_name, char *buf, size_t len);
+
+/* Append a record (see audit_log.h) to the audit log */
+void policy_audit(const char *cmd_name, const char *status, const char *details);
+
+/* Listed commands, in table order; anything else is LVL_USER */
+size_t policy_count(void);
+const CommandMetadata *policy_entry(size_t index);
+
+/* Shell builtins the shell session refuses, since they could switch off
+ * its DEBUG trap (trap, set, shopt, ...); NULL past the end */
+const char *policy_session_builtin(size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DISPATCH_POLICY_H */
@@ -3,85 +3,42 @@
 #include <string.h>
 #include <unistd.h>
 #include <time.h>
-#include <grp.h>
 #include <sys/types.h>
-#include <pwd.h>
 #include <sys/wait.h>
 #include <sched.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 
-#define AUDIT_LOG_FILE "system_audit.log"
-#define ADMIN_GROUP "sudo" 
+#include "dispatch_policy.h"
+#include "audit_log.h"
+#include <glob.h>
 
-
-typedef enum {
-    LVL_USER = 0,     
-    LVL_ADMIN = 1,    
-    LVL_DANGEROUS = 2 
-} PrivilegeLevel;
-
-
-typedef struct {
-    char *name;
-    PrivilegeLevel level;
-    char *warning_msg; 
-    int is_internal;   
-    void (*internal_func)(int argc, char **argv);
-} CommandMetadata;
+// The policy itself (command table, admin check, audit log) lives in
+// dispatch_policy.c and audit_log.c, which mcp_server also links. Build with:
+//   gcc tools/dispatcher.c tools/dispatch_policy.c tools/audit_log.c -o tools/dispatcher -lpthread
 
 
 void cmd_sched(int argc, char **argv);
 void cmd_wipe(int argc, char **argv);
 
 
-CommandMetadata internal_cmds[] = {
-
-    {"sched", LVL_ADMIN, NULL, 1, cmd_sched},
-    {"wipe",  LVL_DANGEROUS, "This clears system caches and logs.", 1, cmd_wipe},
-    {NULL, 0, NULL, 0, NULL}
-};
+// Implementations of the commands the policy table marks internal
+typedef struct {
+    const char *name;
+    void (*internal_func)(int argc, char **argv);
+} InternalCommand;
 
+InternalCommand internal_cmds[] = {
 
-const char *dangerous_binaries[] = {
-    "rm","rmdir", "dd", "mkfs", "fdisk", "reboot", "shutdown", "chmod", "chown","run_shell_command.sh", NULL
+    {"sched", cmd_sched},
+    {"wipe",  cmd_wipe},
+    {NULL, NULL}
 };
 
 
-
-void log_audit(const char *cmd_name, const char *user, const char *status, const char *details) {
-    FILE *fp = fopen(AUDIT_LOG_FILE, "a");
-    if (fp) {
-        time_t now;
-        time(&now);
-        char *date = ctime(&now);
-        date[strlen(date) - 1] = '\0';
-        fprintf(fp, "[%s] USER:%s CMD:%s STATUS:%s MSG:%s\n", date, user, cmd_name, status, details);
-        fclose(fp);
-    }
-}
-
-int is_authorized_user() {
-    uid_t uid = getuid();
-    struct passwd *pw = getpwuid(uid);
-    if (!pw) return 0;
-    if (uid == 0) return 1; // Root is always auth
-
-    int ngroups = 0;
-    getgrouplist(pw->pw_name, pw->pw_gid, NULL, &ngroups);
-    gid_t *groups = malloc(ngroups * sizeof(gid_t));
-    getgrouplist(pw->pw_name, pw->pw_gid, groups, &ngroups);
-
-    struct group *gr = getgrnam(ADMIN_GROUP);
-    if (!gr) { free(groups); return 0; }
-
-    int auth = 0;
-    for (int i = 0; i < ngroups; i++) {
-        if (groups[i] == gr->gr_gid) { auth = 1; break; }
-    }
-    free(groups);
-    return auth;
-}
-
 void cmd_sched(int argc, char **argv) {
     if (argc < 3) {
         printf("[KERNEL] Error: Missing PID. Usage: sched <pid>\n");
@@ -140,153 +97,340 @@ void cmd_wipe(int argc, char **argv) {
     fclose(fp);
 }
 
-// --- Main Logic ---
-
-int main(int argc, char **argv) {
-    // 1. Validation: Ensure exactly one argument is passed
-    // if (argc < 2) {
-    //     fprintf(stderr, "Usage: %s \"string to split\"\n", argv[0]);
-    //     return 1;
-    // }
-
-    // printf("--- Before Modification ---\n");
-    // for (int i = 0; i < argc; i++) {
-    //     printf("argv[%d]: %s\n", i, argv[i]);
-    // }
-   
-    // 2. Duplicate the input string
-    // We do this because strtok modifies the string in-place (adding null terminators).
-    // We want a heap-allocated copy so we don't mess with the original stack/env memory.
-    int start_index;
-    if (strstr(argv[2], "run_shell_command") != NULL)
-        start_index=3;
-    else start_index=2;
-    char *input_copy = strdup(argv[start_index]);
-    if (!input_copy) {
-        perror("strdup failed");
-        return 1;
-    }
-    int exec_dangerous=0;
-    if(strcmp(argv[1],"-y")==0){
-        exec_dangerous=1;
-    }
-   
-    
-    // 3. Count the number of tokens (spaces)
-    int token_count = 0;
-    char *temp_str = strdup(input_copy); // Temp copy just for counting
-    char *token = strtok(temp_str, " ");
-    while (token != NULL) {
-        token_count++;
-        token = strtok(NULL, " ");
+// --- Zygote / warm worker mode ---
+//
+// mcp_server starts one "dispatcher --zygote" at launch, with a
+// SOCK_SEQPACKET control socket on fd 3. Each "W<max_jobs>" request makes
+// the zygote fork a warm worker: an already-loaded copy of this process
+// that skips exec and dynamic linking on every job. The worker's end of a
+// fresh socketpair goes back over the control socket (SCM_RIGHTS) after
+// "P<pid>".
+//
+// Worker protocol, one message per packet:
+//   in:  "J" mode cgroup '\0' program '\0' arg1 '\0' ...   + fd for the job's stdout
+//        mode 'y'|'n': policy check as with -y|-n; 'x': mcp_server already
+//        applied the policy in-process, exec program directly
+//   out: "S<pgid>" once the job runs, "E<status>" when it has exited
+// A worker exits after max_jobs jobs or when its socket closes.
+
+#define ZYGOTE_FD 3
+#define JOB_MAX 65536
+#define MAX_JOB_ARGS 1024
+
+static int dispatch(int argc, char **argv, int exec_dangerous);
+
+static ssize_t recv_with_fd(int sock, char *buf, size_t len, int *fd) {
+    struct iovec iov = { buf, len };
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg = {0};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n;
+    do {
+        n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+
+    *fd = -1;
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (n > 0 && cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+        memcpy(fd, CMSG_DATA(cmsg), sizeof(int));
     }
-    free(temp_str); // Clean up temp copy
+    return n;
+}
 
-    // 4. Allocate memory for the new argv array
-    // Size = 1 (program name) + token_count + 1 (NULL terminator)
-    char **new_argv = malloc((token_count + 2) * sizeof(char *));
-    if (!new_argv) {
-        perror("malloc failed");
-        return 1;
+static int send_with_fd(int sock, const char *buf, size_t len, int fd) {
+    struct iovec iov = { (void *)buf, len };
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg = {0};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    return sendmsg(sock, &msg, MSG_NOSIGNAL) < 0 ? -1 : 0;
+}
+
+// Move the calling process into the cgroup directory dir (see tool_cgroups.hpp).
+// Failure is not fatal: the job then runs unconstrained in the current cgroup.
+static void join_cgroup(const char *dir) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/cgroup.procs", dir);
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    if (write(fd, "0", 1) < 0) perror("join cgroup");
+    close(fd);
+}
+
+static void send_reply(int sock, char kind, long value) {
+    char reply[32];
+    int n = snprintf(reply, sizeof(reply), "%c%ld", kind, value);
+    send(sock, reply, n, MSG_NOSIGNAL);
+}
+
+static void worker_loop(int sock, int max_jobs) {
+    static char job[JOB_MAX];
+    for (int done = 0; max_jobs <= 0 || done < max_jobs; done++) {
+        int out_fd;
+        ssize_t n = recv_with_fd(sock, job, sizeof(job) - 1, &out_fd);
+        if (n <= 0) break;
+        if (job[0] != 'J' || n < 3 || out_fd < 0) {
+            if (out_fd >= 0) close(out_fd);
+            send_reply(sock, 'E', -1);
+            break; // protocol error: let mcp_server replace this worker
+        }
+        job[n] = '\0';
+
+        // "J" mode cgroup-dir NUL program NUL args... (cgroup-dir may be empty)
+        // -> { dispatcher, program, args..., NULL } pointing into the packet
+        char *cgroup = job + 2;
+        char *argv[MAX_JOB_ARGS + 2];
+        int argc = 0;
+        argv[argc++] = "dispatcher";
+        for (char *p = cgroup + strlen(cgroup) + 1; p < job + n && argc <= MAX_JOB_ARGS; p += strlen(p) + 1) {
+            argv[argc++] = p;
+        }
+        argv[argc] = NULL;
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            // Own process group so mcp_server can stop the whole job
+            setpgid(0, 0);
+            if (cgroup[0]) join_cgroup(cgroup);
+            int null_fd = open("/dev/null", O_RDONLY);
+            if (null_fd >= 0) dup2(null_fd, STDIN_FILENO);
+            dup2(out_fd, STDOUT_FILENO);
+            close(sock);
+            if (argc >= 2 && job[1] == 'x') {
+                execvp(argv[1], &argv[1]);
+                perror("[KERNEL] Execution failed");
+                exit(127);
+            }
+            exit(argc < 2 ? 1 : dispatch(argc, argv, job[1] == 'y'));
+        }
+        close(out_fd);
+        if (pid < 0) {
+            send_reply(sock, 'E', -1);
+            continue;
+        }
+        setpgid(pid, pid); // also from here, so the pgid is valid once reported
+        send_reply(sock, 'S', pid);
+
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+        send_reply(sock, 'E', status);
     }
+    close(sock);
+    exit(0);
+}
 
-    // 5. Build the new argv list
-    int new_argc = 0;
-    
-    // Keep the program name (argv[0])
-    new_argv[new_argc++] = argv[0];
-
-    // Tokenize the input_copy and add pointers to new_argv
-    token = strtok(input_copy, " ");
-    while (token != NULL) {
-        new_argv[new_argc++] = token;
-        token = strtok(NULL, " ");
+static int zygote_loop(int ctl) {
+    // Hash the table and open the audit log once; every worker inherits both
+    policy_init();
+    audit_open();
+    // Workers are reaped automatically; each worker restores SIGCHLD for its jobs
+    signal(SIGCHLD, SIG_IGN);
+    char req[32];
+    while (1) {
+        ssize_t n = recv(ctl, req, sizeof(req) - 1, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return 0; // mcp_server went away
+        req[n] = '\0';
+        if (req[0] != 'W') continue;
+        int max_jobs = atoi(req + 1);
+
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) < 0) {
+            send(ctl, "P-1", 3, MSG_NOSIGNAL);
+            continue;
+        }
+        pid_t pid = fork();
+        if (pid == 0) {
+            signal(SIGCHLD, SIG_DFL);
+            close(ctl);
+            close(sv[0]);
+            worker_loop(sv[1], max_jobs);
+        }
+        close(sv[1]);
+        if (pid < 0) {
+            send(ctl, "P-1", 3, MSG_NOSIGNAL);
+        } else {
+            char reply[32];
+            int len = snprintf(reply, sizeof(reply), "P%d", (int)pid);
+            send_with_fd(ctl, reply, len, sv[0]);
+        }
+        close(sv[0]);
     }
-    
-    // Null terminate the array (standard convention for argv)
-    new_argv[new_argc] = NULL;
+}
 
-    // 6. Update main's variables to point to the new data
-    // Note: The original argv[1] is now effectively removed/ignored
-    argc = new_argc;
-    argv = new_argv;
-    // printf("argv:\n");
-    // for(int i=0;i<argc;i++){
-    //     printf("%s\n",argv[i]);
-    // }
-    char *cmd_name = argv[1];
-    //printf("CMD NAME : %s\n",cmd_name);
-    char *user = getenv("USER");
-    if (!user) user = "unknown";
+// --- Main Logic ---
 
-    // --- STEP 1: Identify Command Type ---
-    CommandMetadata meta;
-    
-    // Check Internal Table first
-    int found_internal = 0;
-    for (int i = 0; internal_cmds[i].name != NULL; i++) {
-        if (strcmp(cmd_name, internal_cmds[i].name) == 0) {
-            meta = internal_cmds[i];
-            found_internal = 1;
-            break;
+// Usage: dispatcher [--cgroup DIR] [-y|-n] <program> [args...]
+//        dispatcher --zygote          (fd 3: control socket, see above)
+//        dispatcher --policy
+//        dispatcher --check -y|-n <program>
+//        dispatcher [--cgroup DIR] --exec <program> [args...]
+//        dispatcher --audit-export [FILE...]
+//   --cgroup  join cgroup v2 directory DIR before anything else runs
+//   -y  the user approved dangerous commands, -n (default) they did not
+//   --policy  print "<name> internal|dangerous" per line; any other command
+//             is allowed for everyone
+//   --check   apply the policy (and audit) without running anything; exit 0
+//             if <program> may run. mcp_server's shell session calls this
+//             for each listed command the shell is about to run, and for
+//             names still unexpanded ($c, $(..), globs), which it refuses.
+//   --exec    run <program> without a policy check, for mcp_server after it
+//             made the decision in-process (and only needs --cgroup)
+//   --audit-export  print binary audit records as text lines; default: the
+//             rotated segments in time order, then the current file
+//
+// mcp_server spawns the dispatcher with a real argv, one element per
+// argument, so nothing is re-split here. The legacy packed form
+// (dispatcher -n "program arg1 arg2") is still accepted for manual use.
+int main(int argc, char **argv) {
+    if (argc == 2 && strcmp(argv[1], "--zygote") == 0) {
+        return zygote_loop(ZYGOTE_FD);
+    }
+    if (argc == 2 && strcmp(argv[1], "--policy") == 0) {
+        for (size_t i = 0; i < policy_count(); i++) {
+            const CommandMetadata *entry = policy_entry(i);
+            printf("%s %s\n", entry->name, entry->is_internal ? "internal" : "dangerous");
         }
+        return 0;
     }
-
-    // If not internal, treat as External Linux Command
-    if (!found_internal) {
-        meta.name = cmd_name;
-        meta.is_internal = 0;
-        meta.internal_func = NULL;
-        meta.level = LVL_USER; // Default to safe
-        meta.warning_msg = NULL;
-
-        // Check against Dangerous Blacklist
-        for (int i = 0; dangerous_binaries[i] != NULL; i++) {
-            if (strcmp(cmd_name, dangerous_binaries[i]) == 0) {
-                meta.level = LVL_DANGEROUS;
-                meta.warning_msg = "This is a destructive system utility.";
-                break;
+    if (argc >= 2 && strcmp(argv[1], "--audit-export") == 0) {
+        if (argc > 2) {
+            for (int i = 2; i < argc; i++) {
+                if (audit_export(stdout, argv[i]) < 0) perror(argv[i]);
             }
+            return 0;
         }
+        glob_t segments;
+        if (glob(AUDIT_SEGMENT_PREFIX "*.bin", 0, NULL, &segments) == 0) {
+            for (size_t i = 0; i < segments.gl_pathc; i++) audit_export(stdout, segments.gl_pathv[i]);
+            globfree(&segments);
+        }
+        audit_export(stdout, AUDIT_FILE);
+        return 0;
     }
-
-    // --- STEP 2: Policy Enforcement (PDP) ---
-    
-    // A. Check Permissions
-    if (meta.level >= LVL_ADMIN) {
-        if (!is_authorized_user()) {
-            printf("PERMISSION DENIED: '%s' requires Admin privileges.\n", cmd_name);
-            log_audit(cmd_name, user, "DENIED", "Unauthorized Group");
+    if (argc == 4 && strcmp(argv[1], "--check") == 0) {
+        // The shell sees command names before expansion: one that only
+        // expansion would reveal cannot be checked, so it does not run
+        if (strpbrk(argv[3], "$`*?[{(") != NULL) {
+            policy_audit(argv[3], "DENIED", "Command name not literal");
+            printf("PERMISSION DENIED: '%s' is not a literal command name.\n"
+                   "The shell session checks commands by name; write the name out.\n", argv[3]);
+            return 1;
+        }
+        // Builtins that could switch the session's checks off, and the
+        // session's own __mcp_ functions and variables
+        int reserved = strncmp(argv[3], "__mcp_", 6) == 0;
+        for (size_t i = 0; !reserved && policy_session_builtin(i); i++) {
+            reserved = strcmp(argv[3], policy_session_builtin(i)) == 0;
+        }
+        if (reserved) {
+            policy_audit(argv[3], "DENIED", "Reserved by shell session");
+            printf("PERMISSION DENIED: '%s' is not allowed in the shell session.\n"
+                   "It could change how the session checks commands.\n", argv[3]);
             return 1;
         }
+        CommandMetadata meta;
+        char refusal[512];
+        PolicyVerdict verdict = policy_check(argv[3], strcmp(argv[2], "-y") == 0, &meta);
+        if (verdict != POLICY_ALLOWED) {
+            fputs(policy_refusal(verdict, argv[3], refusal, sizeof(refusal)), stdout);
+            return 1;
+        }
+        policy_audit(argv[3], "ALLOWED", "Passing to shell session");
+        return 0;
     }
 
-    // B. Check Safety (Warning System)
-    if (meta.level == LVL_DANGEROUS) {
-        // printf("\n[KERNEL PROTECTION BOUNDARY]\n");
-        // printf("!!! WARNING: You are attempting to run '%s' !!!\n", cmd_name);
-        // printf("Reason: %s\n", meta.warning_msg);
-        // printf("Confirm execution? (yes/no): ");
-        
-        char resp[10];
-        if(!exec_dangerous) //(!fgets(resp, sizeof(resp), stdin) || strncmp(resp, "yes", 3) != 0) 
-        {
-            printf("Operation Aborted.\n");
-            printf("You either declined the operation or you were not asked for permission\n");
-            printf("If you want to run the process activate HIL and give permission\n");
-            log_audit(cmd_name, user, "ABORTED", "User declined warning");
-            
-            return 0;
+    int exec_dangerous = 0;
+    int first = 1;
+    if (argc > first + 1 && strcmp(argv[first], "--cgroup") == 0) {
+        join_cgroup(argv[first + 1]);
+        first += 2;
+    }
+    if (argc > first + 1 && strcmp(argv[first], "--exec") == 0) {
+        execvp(argv[first + 1], &argv[first + 1]);
+        perror("[KERNEL] Execution failed");
+        return 127;
+    }
+    if (argc > first && (strcmp(argv[first], "-y") == 0 || strcmp(argv[first], "-n") == 0)) {
+        exec_dangerous = (argv[first][1] == 'y');
+        first++;
+    }
+    if (argc > first && strcmp(argv[first], "--") == 0) first++;
+
+    if (argc <= first) {
+        fprintf(stderr, "Usage: %s [--cgroup DIR] [-y|-n] <program> [args...]\n", argv[0]);
+        return 1;
+    }
+
+    // Rebuild argv as { dispatcher, program, args..., NULL }
+    char **new_argv;
+    int new_argc = 0;
+    if (argc - first == 1 && strchr(argv[first], ' ') != NULL) {
+        // Legacy packed form: split on spaces (strtok modifies in place, so copy)
+        char *input_copy = strdup(argv[first]);
+        if (!input_copy) {
+            perror("strdup failed");
+            return 1;
+        }
+        new_argv = malloc((strlen(input_copy) / 2 + 3) * sizeof(char *));
+        if (!new_argv) {
+            perror("malloc failed");
+            return 1;
         }
+        new_argv[new_argc++] = argv[0];
+        char *token = strtok(input_copy, " ");
+        while (token != NULL) {
+            new_argv[new_argc++] = token;
+            token = strtok(NULL, " ");
+        }
+    } else {
+        new_argv = malloc((argc - first + 2) * sizeof(char *));
+        if (!new_argv) {
+            perror("malloc failed");
+            return 1;
+        }
+        new_argv[new_argc++] = argv[0];
+        for (int i = first; i < argc; i++) new_argv[new_argc++] = argv[i];
+    }
+    new_argv[new_argc] = NULL;
+
+    if (new_argc < 2) return 1;
+    return dispatch(new_argc, new_argv, exec_dangerous);
+}
+
+// Policy check, audit and execution for { dispatcher, program, args..., NULL }
+static int dispatch(int argc, char **argv, int exec_dangerous) {
+    char *cmd_name = argv[1];
+
+    // --- STEPS 1-2: Classification and Policy Enforcement (dispatch_policy.c) ---
+    CommandMetadata meta;
+    char refusal[512];
+    PolicyVerdict verdict = policy_check(cmd_name, exec_dangerous, &meta);
+    if (verdict != POLICY_ALLOWED) {
+        fputs(policy_refusal(verdict, cmd_name, refusal, sizeof(refusal)), stdout);
+        return verdict == POLICY_DENIED ? 1 : 0;
     }
 
     // --- STEP 3: Execution ---
     
-    log_audit(cmd_name, user, "ALLOWED", "Passing to execution engine");
+    policy_audit(cmd_name, "ALLOWED", "Passing to execution engine");
 
     if (meta.is_internal) {
         // Run internal C function
-        meta.internal_func(argc, argv);
+        for (int i = 0; internal_cmds[i].name != NULL; i++) {
+            if (strcmp(cmd_name, internal_cmds[i].name) == 0) internal_cmds[i].internal_func(argc, argv);
+        }
     } else {
         // Run external Linux command using execvp
         // We must shift argv so that argv[1] becomes the new argv[0]
@@ -314,4 +458,5 @@ int main(int argc, char **argv) {
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
@@ -0,0 +1,93 @@
+#!/usr/bin/env bash
+
+set -u
+
+usage() {
+  cat <<'EOF'
+Usage: osaudit_query.sh [--user U] [--command C] [--status S] [--since T] [--until T] [--limit N]
+
+Search the dispatcher audit log (system_audit*.bin), newest first.
+T is 7d, 12h, 30m, epoch seconds or a date such as "2026-10-12 14:00".
+mcp_server answers this tool from its indexed audit store; this script is
+the reference implementation and scans the text export.
+EOF
+}
+
+user="" command="" status="" since="" until="" limit=50
+
+while [ $# -gt 0 ]; do
+  case "$1" in
+    --help) usage; exit 0 ;;
+    --user|--command|--status|--since|--until|--limit)
+      if [ $# -lt 2 ]; then
+        echo "Error: $1 needs a value" >&2
+        exit 1
+      fi
+      declare "${1#--}=$2"
+      shift 2 ;;
+    *)
+      echo "Error: unexpected argument '$1'" >&2
+      usage >&2
+      exit 1 ;;
+  esac
+done
+
+# YYYYmmddHHMMSS in local time, the order the export's dates sort in
+to_stamp() {
+  local t="$1"
+  case "$t" in
+    *[0-9]d) t="${t%d} days ago" ;;
+    *[0-9]h) t="${t%h} hours ago" ;;
+    *[0-9]m) t="${t%m} minutes ago" ;;
+    *[0-9]s) t="${t%s} seconds ago" ;;
+    *[!0-9]*) ;;
+    *) t="@$t" ;;
+  esac
+  date -d "$t" +%Y%m%d%H%M%S 2>/dev/null
+}
+
+from="" to=""
+if [ -n "$since" ]; then
+  from=$(to_stamp "$since") || { echo "Error: cannot read since '$since'" >&2; exit 1; }
+fi
+if [ -n "$until" ]; then
+  case "$until" in
+    [0-9][0-9][0-9][0-9]-[0-9][0-9]-[0-9][0-9]) until="$until + 1 day" ;;
+  esac
+  to=$(to_stamp "$until") || { echo "Error: cannot read until '$until'" >&2; exit 1; }
+fi
+
+# mcp_server says which dispatcher it uses; by hand, the one next to this script
+dispatcher="${OLLMCPC_DISPATCHER:-$(dirname "$0")/dispatcher}"
+"$dispatcher" --audit-export | awk -v user="$user" -v cmd="$command" -v status="$status" \
+    -v from="$from" -v to="$to" -v limit="$limit" '
+BEGIN {
+  split("Jan Feb Mar Apr May Jun Jul Aug Sep Oct Nov Dec", names, " ")
+  for (i = 1; i <= 12; i++) month[names[i]] = sprintf("%02d", i)
+  status = toupper(status)
+  sub(/\.sh$/, "", cmd)
+}
+{
+  # [Mon Oct 19 09:46:34 2026] USER:u CMD:c STATUS:s MSG:m
+  split($0, d, /[][ :]+/)
+  stamp = d[8] month[d[3]] sprintf("%02d", d[4]) d[5] d[6] d[7]
+  if (from != "" && stamp < from) next
+  if (to != "" && stamp >= to) next
+  u = $0; sub(/.*\] USER:/, "", u); sub(/ CMD:.*/, "", u)
+  c = $0; sub(/.* CMD:/, "", c); sub(/ STATUS:.*/, "", c)
+  s = $0; sub(/.* STATUS:/, "", s); sub(/ MSG:.*/, "", s)
+  if (user != "" && u != user) next
+  if (status != "" && s != status) next
+  if (cmd != "") {
+    if (index(cmd, "/")) { if (c != cmd) next }
+    else { sub(/.*\//, "", c); sub(/\.sh$/, "", c); if (c != cmd) next }
+  }
+  lines[n++] = $0
+}
+END {
+  if (n == 0) { print "No audit records match"; exit }
+  shown = (n < limit) ? n : limit
+  more = (n > limit) ? "; more match, narrow the filters or raise limit" : ""
+  printf "%d audit records, newest first%s\n", shown, more
+  for (i = n - 1; i >= n - shown; i--) print lines[i]
+}'